@@ -6,15 +6,35 @@ CONFIG += c++17 console
 CONFIG -= app_bundle
 
 DBUS_INTERFACES += ../../interfaces/datamanager.xml
+QDBUSXML2CPP_INTERFACE_HEADER_FLAGS += -i ServerConfig.h
+DBUS_ADAPTORS += ../../interfaces/metrics.xml
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        ../../datamanagerlink.cpp \
+        ../../pipelinemetrics.cpp \
+        ../../printutils.cpp \
+        batterymonitor.cpp \
+        candecoder.cpp \
+        canreader.cpp \
         canreceiver.cpp \
+        canrxbatch.cpp \
+        flightrecorder.cpp \
         ina219.c \
-        main.cpp
+        main.cpp \
+        publishfilter.cpp \
+        publishwakeup.cpp \
+        socestimator.cpp \
+        telemetrystream.cpp
+
+# qmake CONFIG+=alloc_tracking counts heap allocations per pipeline stage.
+alloc_tracking {
+    DEFINES += PI_ALLOC_TRACKING
+    SOURCES += ../../alloctracker.cpp
+}
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -23,8 +43,24 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     ../../ServerConfig.h \
+    ../../alloctracker.h \
+    ../../datamanagerlink.h \
+    ../../latencyhistogram.h \
+    ../../pipelinemetrics.h \
+    ../../printutils.h \
+    ../../seqlock.h \
+    batterymonitor.h \
+    candecoder.h \
+    canreader.h \
     canreceiver.h \
+    canrxbatch.h \
     defs.h \
-    ina219.h
+    flightrecorder.h \
+    ina219.h \
+    publishfilter.h \
+    publishwakeup.h \
+    socestimator.h \
+    spscring.h \
+    telemetrystream.h
 
 INCLUDEPATH += ../../
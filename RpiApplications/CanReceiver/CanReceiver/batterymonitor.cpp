@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <QTimer>
+#include "ServerConfig.h"
+#include "alloctracker.h"
+#include "ina219.h"
+#include "printutils.h"
+#include "batterymonitor.h"
+
+BatteryMonitor::BatteryMonitor(QObject *parent)
+    : QObject{parent}, ina219(NULL), intervalMs(BATTERY_SAMPLE_INTERVAL_MS),
+      estimator(BATTERY_CAPACITY, BATTERY_VOLTAGE_0_PERCENT, BATTERY_VOLTAGE_100_PERCENT),
+      readLatency(NULL), wakeup(NULL), errors(0)
+{
+}
+
+BatteryMonitor::~BatteryMonitor()
+{
+    ina219_destroy(ina219);
+}
+
+bool BatteryMonitor::open()
+{
+    ina219 = ina219_create(I2C_DEV, I2C_ADDR, SHUNT_MILLIOHMS,
+                           BATTERY_VOLTAGE_0_PERCENT, BATTERY_VOLTAGE_100_PERCENT,
+                           BATTERY_CAPACITY, MIN_CHARGING_CURRENT);
+    char *error = NULL;
+    if (!ina219_init(ina219, &error))
+    {
+        LOG_ERROR("Battery line init fail %s", error ? error : "");
+        free(error);
+        ina219_destroy(ina219);
+        ina219 = NULL;
+        return false;
+    }
+    LOG_INFO("Success to battery line init");
+    return true;
+}
+
+// Runs in the battery thread: the timer must belong to the thread whose
+// event loop services it.
+void BatteryMonitor::start()
+{
+    timer = std::make_shared<QTimer>();
+    connect(timer.get(), SIGNAL(timeout()), this, SLOT(sample()));
+    timer->start(intervalMs);
+    sample();
+}
+
+void BatteryMonitor::stop()
+{
+    if (timer)
+        timer->stop();
+    timer.reset();
+}
+
+void BatteryMonitor::sample()
+{
+    ALLOC_STAGE(AllocStageBattery);
+    if (!ina219)
+        return;
+
+    BatteryStatus reading;
+    int shuntUv;
+    char *error = NULL;
+    int64_t readStart = currentTimeNs();
+    if (!ina219_get_bus_voltage(ina219, &reading.voltageMv, &error) ||
+            !ina219_get_shunt_voltage_uv(ina219, &shuntUv, &error))
+    {
+        errors.fetch_add(1, std::memory_order_relaxed);
+        LOG_ERROR("Failed to get battery : %s", error ? error : "");
+        free(error);
+        return;
+    }
+    reading.stampNs = currentTimeNs();
+    if (readLatency)
+        readLatency->record(reading.stampNs - readStart);
+
+    // uV / milliohm = mA
+    double currentMa = double(shuntUv) / SHUNT_MILLIOHMS;
+    estimator.update(reading.stampNs, reading.voltageMv, currentMa);
+
+    reading.currentMa = int(currentMa);
+    reading.percent = estimator.percent();
+    reading.minutes = estimator.minutesRemaining(MIN_CHARGING_CURRENT);
+    if (estimator.averageCurrentMa() > MIN_CHARGING_CURRENT)
+        reading.chargeStatus = INA219_CHARGING;
+    else if (reading.percent >= INA_FULL_PERCENT || estimator.averageCurrentMa() >= -MIN_CHARGING_CURRENT)
+        reading.chargeStatus = INA219_FULLY_CHARGED;
+    else
+        reading.chargeStatus = INA219_DISCHARGING;
+    status.store(reading);
+    if (wakeup)
+        wakeup->notify();
+}
+
+bool BatteryMonitor::latest(BatteryStatus &out) const
+{
+    if (!version())
+        return false;
+    status.load(out);
+    return true;
+}
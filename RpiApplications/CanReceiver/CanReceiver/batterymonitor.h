@@ -0,0 +1,80 @@
+#ifndef BATTERYMONITOR_H
+#define BATTERYMONITOR_H
+
+#include <QObject>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include "latencyhistogram.h"
+#include "publishwakeup.h"
+#include "seqlock.h"
+#include "socestimator.h"
+
+#define I2C_ADDR 0x42
+#define I2C_DEV "/dev/i2c-1"
+#define BATTERY_VOLTAGE_100_PERCENT 8400
+#define BATTERY_VOLTAGE_0_PERCENT 6000
+#define BATTERY_CAPACITY 2400
+#define MIN_CHARGING_CURRENT 10
+#define SHUNT_MILLIOHMS 100
+
+#define BATTERY_SAMPLE_INTERVAL_MS 5000
+
+typedef struct _INA219 INA219;
+
+// One INA219 reading as published by the battery worker. percent and
+// minutes come from the SoC estimator, not the raw voltage.
+struct BatteryStatus {
+    int64_t stampNs;
+    int voltageMv;
+    int currentMa;
+    int percent;
+    int minutes;
+    int chargeStatus;
+};
+
+// Owns the INA219. After open() the object is moved to its own QThread and
+// start() arms the sampling timer there, so a slow or stuck I2C bus never
+// stalls the event loop that publishes CAN data. Every sample feeds the
+// SocEstimator, and the result is stored in a SeqLock; the publisher picks
+// it up without taking a lock.
+class BatteryMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatteryMonitor(QObject *parent = nullptr);
+    ~BatteryMonitor();
+
+    bool open();
+    void setInterval(int ms) { intervalMs = ms; }
+    // Optional; receives the duration of every successful read.
+    void setLatencyHistogram(LatencyHistogram *histogram) { readLatency = histogram; }
+    // Notified after each published reading.
+    void setWakeup(PublishWakeup *publishWakeup) { wakeup = publishWakeup; }
+
+    // Safe from any thread. False until the first successful sample.
+    bool latest(BatteryStatus &out) const;
+    // Changes whenever a new reading is published.
+    uint32_t version() const { return status.version(); }
+    uint64_t readErrors() const { return errors.load(std::memory_order_relaxed); }
+
+public slots:
+    void start();
+    // Stops and releases the timer; connect to the thread's finished()
+    // with a direct connection so it runs on the thread that owns it.
+    void stop();
+    void sample();
+
+private:
+    INA219 *ina219;
+    int intervalMs;
+    std::shared_ptr<class QTimer> timer;
+    SocEstimator estimator;
+    SeqLock<BatteryStatus> status;
+    LatencyHistogram *readLatency;
+    PublishWakeup *wakeup;
+    std::atomic<uint64_t> errors;
+};
+
+#endif // BATTERYMONITOR_H
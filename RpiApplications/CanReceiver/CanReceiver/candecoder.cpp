@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <endian.h>
+#include <math.h>
+#include <string.h>
+#include "ServerConfig.h"
+#include "candecoder.h"
+
+// Each table's rows are written once, as a macro, and expand both into the
+// table itself and into "default", which decodes every known frame.
+
+// Arduino speed frame: bytes 0-1 rpm (big-endian), byte 2 temp, byte 3 hum.
+// Protocol v2: byte 0 version, byte 1 sequence, bytes 2-3 rpm and 4-5 the
+// sender's millis() (big-endian), byte 6 temp, byte 7 hum.
+#define ARDUINO_SIGNALS \
+    /* id               start len  byte order              signed scale offset field */ \
+    { SPEED_FRAME_ID,   7,    16,  CanSignal::BigEndian,    false, 1.0,  0.0,   FieldRpm  }, \
+    { SPEED_FRAME_ID,   16,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldTemp }, \
+    { SPEED_FRAME_ID,   24,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldHum  }, \
+    { TELEMETRY_V2_ID,  0,    8,   CanSignal::LittleEndian, false, 1.0,  0.0,   SIGNAL_FIELD_VERSION }, \
+    { TELEMETRY_V2_ID,  8,    8,   CanSignal::LittleEndian, false, 1.0,  0.0,   SIGNAL_FIELD_SEQUENCE }, \
+    { TELEMETRY_V2_ID,  23,   16,  CanSignal::BigEndian,    false, 1.0,  0.0,   FieldRpm  }, \
+    { TELEMETRY_V2_ID,  39,   16,  CanSignal::BigEndian,    false, 1e6,  0.0,   SIGNAL_FIELD_SENDER_TIME }, \
+    { TELEMETRY_V2_ID,  48,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldTemp }, \
+    { TELEMETRY_V2_ID,  56,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldHum  }
+
+// Latency probe: bytes 0-1 rpm, 2-7 the injection time in us.
+#define PROBE_SIGNALS \
+    { LATENCY_PROBE_ID, 7,    16,  CanSignal::BigEndian,    false, 1.0,  0.0,   FieldRpm  }, \
+    { LATENCY_PROBE_ID, 23,   48,  CanSignal::BigEndian,    false, 1000, 0.0,   SIGNAL_FIELD_STAMP }
+
+// CAN FD telemetry, all little-endian: rpm, temp, hum, battery, and a
+// 48-bit us stamp at byte 8.
+#define FD_SIGNALS \
+    { TELEMETRY_FD_ID,  0,    16,  CanSignal::LittleEndian, false, 1.0,  0.0,   FieldRpm  }, \
+    { TELEMETRY_FD_ID,  16,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldTemp }, \
+    { TELEMETRY_FD_ID,  24,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldHum  }, \
+    { TELEMETRY_FD_ID,  32,   8,   CanSignal::LittleEndian, false, 1.0,  0.0,   FieldBattery }, \
+    { TELEMETRY_FD_ID,  64,   48,  CanSignal::LittleEndian, false, 1000, 0.0,   SIGNAL_FIELD_STAMP }
+
+static const CanSignal arduinoSignals[] = { ARDUINO_SIGNALS };
+static const CanSignal probeSignals[] = { PROBE_SIGNALS };
+static const CanSignal fdSignals[] = { FD_SIGNALS };
+
+const CanSignal defaultSignalTable[] = { ARDUINO_SIGNALS, PROBE_SIGNALS, FD_SIGNALS };
+const int defaultSignalCount = sizeof(defaultSignalTable) / sizeof(defaultSignalTable[0]);
+
+#define SIGNAL_TABLE(name, rows) { name, rows, int(sizeof(rows) / sizeof(rows[0])) }
+
+const CanSignalTable signalTables[] = {
+    { "default", defaultSignalTable, defaultSignalCount },
+    SIGNAL_TABLE("arduino", arduinoSignals),
+    SIGNAL_TABLE("probe", probeSignals),
+    SIGNAL_TABLE("fd", fdSignals),
+};
+const int signalTableCount = sizeof(signalTables) / sizeof(signalTables[0]);
+
+const CanSignalTable *findSignalTable(const char *name)
+{
+    for (int i = 0; i < signalTableCount; i++)
+    {
+        if (strcmp(signalTables[i].name, name) == 0)
+            return &signalTables[i];
+    }
+    return nullptr;
+}
+
+static canid_t messageKey(canid_t canId)
+{
+    if (canId & CAN_EFF_FLAG)
+        return canId & (CAN_EFF_FLAG | CAN_EFF_MASK);
+    return canId & CAN_SFF_MASK;
+}
+
+CanDecoder::CanDecoder(const CanSignal *table, int count)
+    : standardIndex(CAN_SFF_MASK + 1, NoMessage)
+{
+    std::vector<CanSignal> sorted(table, table + count);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const CanSignal &a, const CanSignal &b) {
+        return messageKey(a.canId) < messageKey(b.canId);
+    });
+
+    for (const CanSignal &sig : sorted)
+    {
+        if (sig.length == 0 || sig.length > 64)
+            continue;
+
+        Extractor ex;
+        ex.bigEndian = sig.byteOrder == CanSignal::BigEndian;
+        ex.isSigned = sig.isSigned;
+        ex.length = sig.length;
+        ex.mask = sig.length == 64 ? ~uint64_t(0) : ((uint64_t(1) << sig.length) - 1);
+        ex.scale = sig.scale;
+        ex.offset = sig.offset;
+        ex.field = sig.field;
+
+        // Bits are counted from the first bit on the wire; the 8-byte
+        // window starts at the signal's first byte.
+        int firstBit;
+        int lastBit;
+        if (ex.bigEndian)
+        {
+            // Position of the MSB.
+            firstBit = (sig.startBit / 8) * 8 + (7 - sig.startBit % 8);
+            lastBit = firstBit + sig.length - 1;
+            ex.shift = uint8_t(64 - firstBit % 8 - sig.length);
+        }
+        else
+        {
+            firstBit = (sig.startBit / 8) * 8;
+            lastBit = sig.startBit + sig.length - 1;
+            ex.shift = uint8_t(sig.startBit % 8);
+        }
+        if (lastBit >= CANFD_MAX_DLEN * 8 || lastBit - (firstBit / 8) * 8 >= 64)
+            continue;
+        ex.byteOffset = uint8_t(firstBit / 8);
+        ex.bytesNeeded = uint8_t(lastBit / 8 + 1);
+
+        canid_t key = messageKey(sig.canId);
+        if (messages.empty() || messages.back().canId != key)
+            messages.push_back({ key, uint32_t(extractors.size()), 0 });
+        messages.back().count++;
+        extractors.push_back(ex);
+    }
+
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        if (!(messages[i].canId & CAN_EFF_FLAG))
+            standardIndex[messages[i].canId] = uint16_t(i);
+    }
+}
+
+std::vector<struct can_filter> CanDecoder::filters() const
+{
+    std::vector<struct can_filter> result;
+    result.reserve(messages.size());
+    for (const Message &msg : messages)
+    {
+        struct can_filter filter;
+        filter.can_id = msg.canId;
+        if (msg.canId & CAN_EFF_FLAG)
+            filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK;
+        else
+            filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK;
+        result.push_back(filter);
+    }
+    return result;
+}
+
+const CanDecoder::Message *CanDecoder::find(canid_t canId) const
+{
+    if (canId & (CAN_RTR_FLAG | CAN_ERR_FLAG))
+        return nullptr;
+
+    if (!(canId & CAN_EFF_FLAG))
+    {
+        uint16_t index = standardIndex[canId & CAN_SFF_MASK];
+        return index == NoMessage ? nullptr : &messages[index];
+    }
+
+    canid_t key = messageKey(canId);
+    auto it = std::lower_bound(messages.begin(), messages.end(), key,
+                               [](const Message &msg, canid_t id) { return msg.canId < id; });
+    if (it == messages.end() || it->canId != key)
+        return nullptr;
+    return &*it;
+}
+
+// Decodes every known signal of the frame into out and returns the mask of
+// Data fields that were written (a stamp signal sets out.stamp but no mask
+// bit; transport signals go to meta). Signals that do not fit in the
+// received length are skipped.
+uint32_t CanDecoder::decode(const struct canfd_frame &frame, struct Data &out, CanFrameMeta &meta) const
+{
+    meta.present = 0;
+    const Message *msg = find(frame.can_id);
+    if (!msg)
+        return 0;
+
+    // Zero padding behind the payload keeps every 8-byte load in bounds
+    // and reads bytes past len as zero.
+    uint8_t len = frame.len > CANFD_MAX_DLEN ? CANFD_MAX_DLEN : frame.len;
+    uint8_t payload[CANFD_MAX_DLEN + 8];
+    memcpy(payload, frame.data, len);
+    memset(payload + len, 0, sizeof(payload) - len);
+
+    uint32_t changed = 0;
+    const Extractor *ex = &extractors[msg->first];
+    for (uint32_t i = 0; i < msg->count; i++, ex++)
+    {
+        if (ex->bytesNeeded > len)
+            continue;
+
+        uint64_t window;
+        memcpy(&window, payload + ex->byteOffset, sizeof(window));
+        window = ex->bigEndian ? be64toh(window) : le64toh(window);
+        uint64_t raw = (window >> ex->shift) & ex->mask;
+        switch (ex->field)
+        {
+        case SIGNAL_FIELD_STAMP:
+            out.stamp = int64_t(raw) * int64_t(ex->scale) + int64_t(ex->offset);
+            continue;
+        case SIGNAL_FIELD_VERSION:
+            meta.version = uint32_t(raw);
+            meta.present |= CanFrameMeta::HasVersion;
+            continue;
+        case SIGNAL_FIELD_SEQUENCE:
+            meta.sequence = uint32_t(raw);
+            meta.sequenceBits = ex->length;
+            meta.present |= CanFrameMeta::HasSequence;
+            continue;
+        case SIGNAL_FIELD_SENDER_TIME:
+            meta.senderTimeNs = int64_t(raw) * int64_t(ex->scale) + int64_t(ex->offset);
+            meta.senderTimeWrapNs = int64_t(ex->mask + 1) * int64_t(ex->scale);
+            meta.present |= CanFrameMeta::HasSenderTime;
+            continue;
+        }
+
+        double value;
+        if (ex->isSigned && ex->length < 64 && (raw >> (ex->length - 1)) & 1)
+            value = double(int64_t(raw | ~ex->mask));
+        else
+            value = ex->isSigned ? double(int64_t(raw)) : double(raw);
+
+        out.field(ex->field) = int(lround(value * ex->scale + ex->offset));
+        changed |= DATA_FIELD_BIT(ex->field);
+    }
+    return changed;
+}
@@ -0,0 +1,125 @@
+#ifndef CANDECODER_H
+#define CANDECODER_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include <vector>
+
+struct Data;
+
+# define SPEED_FRAME_ID 0x43
+// Arduino telemetry protocol v2: version, sequence, rpm, sender time in
+// ms (16 bits) and two extra channels; see can_transmitter.ino.
+# define TELEMETRY_V2_ID 0x44
+# define TELEMETRY_PROTOCOL_VERSION 2
+// CAN FD telemetry frame, all little-endian: rpm in bytes 0-1, temp,
+// hum and battery in bytes 2-4, and the low 48 bits of the CLOCK_REALTIME
+// source time in microseconds in bytes 8-13. The rest is free for more
+// signals.
+# define TELEMETRY_FD_ID 0x143
+// Benchmark frame: rpm in bytes 0-1 and the low 48 bits of the
+// CLOCK_REALTIME injection time in microseconds in bytes 2-7 (both
+// big-endian). The receiver restores the high bits from its RX time.
+# define LATENCY_PROBE_ID 0x7E0
+
+// Pseudo field: the signal is a source timestamp and is stored, in integer
+// arithmetic, into Data::stamp as raw * scale + offset nanoseconds.
+# define SIGNAL_FIELD_STAMP -1
+// Pseudo fields for sequenced protocols, stored into CanFrameMeta. The
+// sender time is raw * scale + offset nanoseconds on the sender's own
+// clock; it wraps every 2^length * scale ns.
+# define SIGNAL_FIELD_VERSION -2
+# define SIGNAL_FIELD_SEQUENCE -3
+# define SIGNAL_FIELD_SENDER_TIME -4
+
+// One row of a DBC-style signal table. startBit follows the DBC
+// convention: for little-endian (Intel) signals it is the position of the
+// least significant bit, for big-endian (Motorola) signals the position of
+// the most significant bit, both numbered byte * 8 + bit (bit 7 = MSB).
+// physical = raw * scale + offset, stored into Data::field(field).
+struct CanSignal {
+    enum ByteOrder { LittleEndian, BigEndian };
+
+    canid_t canId;
+    uint8_t startBit;
+    uint8_t length;
+    ByteOrder byteOrder;
+    bool isSigned;
+    double scale;
+    double offset;
+    int field;
+};
+
+// Transport fields of a decoded frame; present is a mask of Has* bits.
+struct CanFrameMeta {
+    enum { HasVersion = 1, HasSequence = 2, HasSenderTime = 4 };
+
+    uint32_t present;
+    uint32_t version;
+    uint32_t sequence;
+    uint32_t sequenceBits;
+    int64_t senderTimeNs;
+    int64_t senderTimeWrapNs;
+};
+
+extern const CanSignal defaultSignalTable[];
+extern const int defaultSignalCount;
+
+// A named slice of signals, selected per bus on the command line
+// (--interface can1:probe).
+struct CanSignalTable {
+    const char *name;
+    const CanSignal *entries;
+    int count;
+};
+
+extern const CanSignalTable signalTables[];
+extern const int signalTableCount;
+
+// Null when no table has that name.
+const CanSignalTable *findSignalTable(const char *name);
+
+// Compiles a signal table into per-ID extractor lists. Standard 11-bit IDs
+// are dispatched through a direct lookup table, extended IDs by binary
+// search, so decode() never walks the whole table. Signals may sit anywhere
+// in a 64-byte CAN FD payload; each is read as one 8-byte load at its first
+// byte, so a signal must fit within the 8 bytes starting there.
+class CanDecoder
+{
+public:
+    CanDecoder(const CanSignal *table, int count);
+
+    std::vector<struct can_filter> filters() const;
+    // Classic frames decode the same way; their bytes beyond len are zero.
+    uint32_t decode(const struct canfd_frame &frame, struct Data &out, CanFrameMeta &meta) const;
+
+private:
+    struct Extractor {
+        uint8_t byteOffset;
+        uint8_t shift;
+        uint8_t bytesNeeded;
+        bool bigEndian;
+        bool isSigned;
+        uint8_t length;
+        uint64_t mask;
+        double scale;
+        double offset;
+        int field;
+    };
+
+    struct Message {
+        canid_t canId;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    static constexpr uint16_t NoMessage = 0xffff;
+
+    std::vector<Extractor> extractors;
+    std::vector<Message> messages;
+    std::vector<uint16_t> standardIndex;
+
+    const Message *find(canid_t canId) const;
+};
+
+#endif // CANDECODER_H
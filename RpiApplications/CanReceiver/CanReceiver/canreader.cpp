@@ -0,0 +1,235 @@
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <QSocketNotifier>
+#include "alloctracker.h"
+#include "printutils.h"
+#include "canreader.h"
+
+// A probe stamp holds only the low 48 bits of the microsecond clock; pick
+// the latest full time with those low bits that is not after the RX time.
+static int64_t extendProbeStamp(int64_t truncatedNs, int64_t rxNs)
+{
+    const int64_t wrap = int64_t(1) << 48;
+    int64_t rxUs = rxNs / 1000;
+    int64_t age = (rxUs - truncatedNs / 1000) & (wrap - 1);
+    return (rxUs - age) * 1000;
+}
+
+// Data frame without stuffing: SOF, arbitration, control, CRC, ACK, EOF
+// and interframe space, plus the payload. FD frames are counted as if sent
+// without bit rate switching, so with BRS this overstates their share.
+static uint32_t frameBits(const struct canfd_frame &frame)
+{
+    uint32_t header = (frame.can_id & CAN_EFF_FLAG) ? 20 : 0;
+    if (frame.flags & CANFD_FDF)
+        header += frame.len > 16 ? 67 : 63;
+    else
+        header += 47;
+    return header + 8 * frame.len;
+}
+
+CanReader::CanReader(uint8_t bus, const CanSignal *table, int count, QObject *parent)
+    : QObject{parent}, bus(bus), socketFD(-1), decoder(table, count), delayHistogram(nullptr),
+      wakeup(nullptr), received(0), errors(0), overflows(0), drops(0), undecoded(0), extended(0), bits(0),
+      sequenced(0), lost(0), late(0), unsupported(0)
+{
+    for (std::atomic<uint64_t> &count : idFrames)
+        count.store(0, std::memory_order_relaxed);
+    streams.reserve(CAN_STREAMS_RESERVED);
+}
+
+CanReader::~CanReader()
+{
+    if (socketFD >= 0)
+        close(socketFD);
+}
+
+bool CanReader::open(const QString &ifname)
+{
+    this->ifname = ifname;
+    socketFD = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (socketFD < 0)
+    {
+        LOG_ERROR("Failed to socket create : %s", qPrintable(ifname));
+        return false;
+    }
+    LOG_INFO("Success to socket create : %s", qPrintable(ifname));
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname.toStdString().c_str(), IFNAMSIZ - 1);
+    int ret = ioctl(socketFD, SIOCGIFINDEX, &ifr);
+    if (ret < 0)
+    {
+        LOG_ERROR("Failed to get CAN interface index : %s", qPrintable(ifname));
+        return false;
+    }
+    LOG_INFO("Success to get CAN interface index : %s %d", qPrintable(ifname), ifr.ifr_ifindex);
+
+    // Classic and FD frames arrive on the same socket; an interface with a
+    // classic MTU simply never delivers FD ones.
+    int fdFrames = 1;
+    if (setsockopt(socketFD, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &fdFrames, sizeof(fdFrames)) < 0)
+        LOG_WARN("CAN FD frames unavailable : %s", qPrintable(ifname));
+
+    // Only frames named in the signal table reach user space, unless the
+    // flight recorder wants the whole bus.
+    if (!recorder)
+    {
+        std::vector<struct can_filter> filters = decoder.filters();
+        ret = setsockopt(socketFD, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                         filters.size() * sizeof(struct can_filter));
+        if (ret < 0)
+        {
+            LOG_ERROR("Failed to set CAN filters");
+            return false;
+        }
+        LOG_INFO("Success to set CAN filters : %zu", filters.size());
+    }
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    ret = bind(socketFD, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret < 0)
+    {
+        LOG_ERROR("Failed to socket bind : %s", qPrintable(ifname));
+        LOG_ERROR("Error code : %d", ret);
+        return false;
+    }
+    LOG_INFO("Success to socket bind : %s", qPrintable(ifname));
+
+    if (CanRxBatch::enableTimestamps(socketFD) < 0)
+        LOG_WARN("Kernel RX timestamps unavailable, using receive time");
+    if (CanRxBatch::enableDropCounter(socketFD) < 0)
+        LOG_WARN("Kernel drop counter unavailable");
+
+    // readData() is driven by socket readiness and drains the queue until
+    // EAGAIN, so the descriptor must never block.
+    ret = fcntl(socketFD, F_SETFL, fcntl(socketFD, F_GETFL) | O_NONBLOCK);
+    if (ret < 0)
+    {
+        LOG_ERROR("Failed to set CAN socket non-blocking");
+        return false;
+    }
+    return true;
+}
+
+// Streams are few (one per sequenced ID), so a linear search is enough.
+TelemetryStream &CanReader::stream(canid_t canId)
+{
+    for (TelemetryStream &known : streams)
+    {
+        if (known.id() == canId)
+            return known;
+    }
+    streams.push_back(TelemetryStream(canId));
+    return streams.back();
+}
+
+// Runs in the reader thread: the notifier must be created by the thread
+// whose event loop services it.
+void CanReader::start()
+{
+    canNotifier = std::make_shared<QSocketNotifier>(socketFD, QSocketNotifier::Read);
+    connect(canNotifier.get(), SIGNAL(activated(int)), this, SLOT(readData()));
+}
+
+void CanReader::stop()
+{
+    canNotifier.reset();
+}
+
+int CanReader::readData()
+{
+    ALLOC_STAGE(AllocStageCanRead);
+    int frames = 0;
+
+    for (;;)
+    {
+        int count = rxBatch.receive(socketFD);
+        if (count < 0)
+        {
+            errors.fetch_add(1, std::memory_order_relaxed);
+            return count;
+        }
+
+        uint64_t batchBits = 0;
+        bool queued = false;
+        for (int n = 0; n < count; n++)
+        {
+            if (recorder)
+                recorder->append(rxBatch.frame(n), rxBatch.stamp(n), bus);
+            batchBits += frameBits(rxBatch.frame(n));
+
+            CanSample sample;
+            sample.bus = bus;
+            sample.canId = rxBatch.frame(n).can_id;
+            if (sample.canId & CAN_EFF_FLAG)
+                extended.fetch_add(1, std::memory_order_relaxed);
+            else
+                idFrames[sample.canId & CAN_SFF_MASK].fetch_add(1, std::memory_order_relaxed);
+
+            CanFrameMeta meta;
+            sample.values = Data();
+            sample.fields = decoder.decode(rxBatch.frame(n), sample.values, meta);
+            if (!sample.fields)
+            {
+                undecoded.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if ((meta.present & CanFrameMeta::HasVersion) && meta.version != TELEMETRY_PROTOCOL_VERSION)
+            {
+                unsupported.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // Probe frames carry their own injection time.
+            sample.stampNs = rxBatch.stamp(n);
+            if (sample.values.stamp)
+                sample.stampNs = extendProbeStamp(sample.values.stamp, sample.stampNs);
+
+            if (meta.present & CanFrameMeta::HasSequence)
+            {
+                uint32_t skipped;
+                TelemetryStream::Order order = stream(sample.canId).checkSequence(meta, skipped);
+                sequenced.fetch_add(1, std::memory_order_relaxed);
+                if (order == TelemetryStream::Late)
+                {
+                    // Its values are older than ones already queued.
+                    late.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                lost.fetch_add(skipped, std::memory_order_relaxed);
+            }
+            if (meta.present & CanFrameMeta::HasSenderTime)
+            {
+                sample.stampNs = stream(sample.canId).senderToLocal(meta, rxBatch.stamp(n));
+                if (delayHistogram)
+                    delayHistogram->record(rxBatch.stamp(n) - sample.stampNs);
+            }
+            if (ring.push(sample))
+                queued = true;
+            else
+                overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (queued && wakeup)
+            wakeup->notify();
+
+        frames += count;
+        received.fetch_add(count, std::memory_order_relaxed);
+        bits.fetch_add(batchBits, std::memory_order_relaxed);
+        drops.store(rxBatch.kernelDrops(), std::memory_order_relaxed);
+
+        // A short batch means the socket queue is already empty.
+        if (!rxBatch.full())
+            break;
+    }
+
+    return frames;
+}
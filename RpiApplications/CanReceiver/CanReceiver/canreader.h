@@ -0,0 +1,121 @@
+#ifndef CANREADER_H
+#define CANREADER_H
+
+#include <QObject>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "ServerConfig.h"
+#include "candecoder.h"
+#include "canrxbatch.h"
+#include "flightrecorder.h"
+#include "latencyhistogram.h"
+#include "publishwakeup.h"
+#include "spscring.h"
+#include "telemetrystream.h"
+
+# define CAN_SAMPLE_RING_SIZE 1024
+// Sequenced CAN IDs a reader tracks without growing its stream table.
+# define CAN_STREAMS_RESERVED 8
+
+// One decoded frame as handed from the reader thread to the publisher.
+// fields is the DATA_FIELD_BIT mask of the values the frame carried.
+// stampNs is when the values were sampled, as far as the frame tells: the
+// sender time for stamped protocols, otherwise the kernel RX time.
+struct CanSample {
+    int64_t stampNs;
+    canid_t canId;
+    uint32_t fields;
+    uint8_t bus;
+    struct Data values;
+};
+
+typedef SpscRing<CanSample, CAN_SAMPLE_RING_SIZE> CanSampleRing;
+
+// Owns the raw CAN socket of one bus. After open() the object is moved to
+// its own QThread; start() then arms a QSocketNotifier there, so socket
+// reads and decoding never wait behind console, I2C or D-Bus work on the
+// main thread, nor behind the other buses. bus is the index stamped on
+// samples and flight records.
+class CanReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    CanReader(uint8_t bus, const CanSignal *table, int count, QObject *parent = nullptr);
+    ~CanReader();
+
+    // Must be called before open(); recording disables the kernel ID filter
+    // so every frame on the bus is captured.
+    void setRecorder(const std::shared_ptr<FlightRecorder> &flightRecorder) { recorder = flightRecorder; }
+    // Receives, per sender-stamped frame, the time from sampling on the
+    // sender to kernel RX, above the fixed minimum. Before start().
+    void setDelayHistogram(LatencyHistogram *histogram) { delayHistogram = histogram; }
+    // Notified after each batch that queued samples.
+    void setWakeup(PublishWakeup *publishWakeup) { wakeup = publishWakeup; }
+    bool open(const QString &ifname);
+
+    uint8_t busIndex() const { return bus; }
+    const QString &interfaceName() const { return ifname; }
+
+    // Consumer side, called from the publisher thread only.
+    const CanSample *peekSample() { return ring.front(); }
+    bool takeSample(CanSample &sample) { return ring.pop(sample); }
+
+    uint64_t framesReceived() const { return received.load(std::memory_order_relaxed); }
+    uint64_t readErrors() const { return errors.load(std::memory_order_relaxed); }
+    uint64_t ringOverflows() const { return overflows.load(std::memory_order_relaxed); }
+    uint64_t kernelDrops() const { return drops.load(std::memory_order_relaxed); }
+    // Frames that carried no signal from the table.
+    uint64_t decodeFailures() const { return undecoded.load(std::memory_order_relaxed); }
+    // Per standard ID; all extended IDs share one count.
+    uint64_t framesForId(canid_t id) const { return idFrames[id & CAN_SFF_MASK].load(std::memory_order_relaxed); }
+    uint64_t extendedFrames() const { return extended.load(std::memory_order_relaxed); }
+    // Nominal bits on the wire, bit stuffing excluded; the rate of this
+    // divided by the bitrate is the bus load.
+    uint64_t wireBits() const { return bits.load(std::memory_order_relaxed); }
+    // Sequenced protocols: frames checked, frames missing when a later one
+    // arrived, and frames that arrived after a newer one (dropped).
+    uint64_t sequencedFrames() const { return sequenced.load(std::memory_order_relaxed); }
+    uint64_t sequenceLost() const { return lost.load(std::memory_order_relaxed); }
+    uint64_t sequenceLate() const { return late.load(std::memory_order_relaxed); }
+    // Frames whose protocol version this build does not know (dropped).
+    uint64_t unsupportedVersions() const { return unsupported.load(std::memory_order_relaxed); }
+
+public slots:
+    void start();
+    // Releases the notifier; connect to the thread's finished() with a
+    // direct connection so it runs on the thread that created it.
+    void stop();
+    int readData();
+
+private:
+    uint8_t bus;
+    QString ifname;
+    int socketFD;
+    CanRxBatch rxBatch;
+    CanDecoder decoder;
+    CanSampleRing ring;
+    std::shared_ptr<class QSocketNotifier> canNotifier;
+    std::shared_ptr<FlightRecorder> recorder;
+    LatencyHistogram *delayHistogram;
+    PublishWakeup *wakeup;
+    std::vector<TelemetryStream> streams;
+
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> overflows;
+    std::atomic<uint64_t> drops;
+    std::atomic<uint64_t> undecoded;
+    std::atomic<uint64_t> extended;
+    std::atomic<uint64_t> bits;
+    std::atomic<uint64_t> sequenced;
+    std::atomic<uint64_t> lost;
+    std::atomic<uint64_t> late;
+    std::atomic<uint64_t> unsupported;
+    std::atomic<uint64_t> idFrames[CAN_SFF_MASK + 1];
+
+    TelemetryStream &stream(canid_t canId);
+};
+
+#endif // CANREADER_H
@@ -1,32 +1,39 @@
-#include <linux/can/raw.h>
-#include <net/if.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
-#include <errno.h>
-#include <string.h>
-#include <unistd.h>
 #include <stdint.h>
-#include <iostream>
-#include <iomanip>
-#include <QDebug>
+#include <QSocketNotifier>
+#include <QThread>
 #include <QTimer>
 #include "ServerConfig.h"
-#include "ina219.h"
+#include "alloctracker.h"
+#include "datamanagerlink.h"
+#include "metrics_adaptor.h"
 #include "canreceiver.h"
 
 CanReceiver::CanReceiver(QObject *parent)
-    : QObject{parent}, socketFD(0), canData(new struct Data), inaStatus(0),
-      ina219(NULL), canTimer(std::make_shared<QTimer>()),
-      dbusTimer(std::make_shared<QTimer>()), batteryTimer(std::make_shared<QTimer>())
+    : QObject{parent}, canData(), batteryVersion(0),
+      batteryInterval(BATTERY_SAMPLE_INTERVAL_MS), dataManager(nullptr), dataManagerPeer(false),
+      serviceWatcher(nullptr), dbusTimer(std::make_shared<QTimer>()),
+      metricsTimer(std::make_shared<QTimer>()), metrics(std::make_shared<PipelineMetrics>())
 {
     qDBusRegisterMetaType<struct Data>();
-    connect(canTimer.get(), SIGNAL(timeout()), this, SLOT(readData()));
     connect(dbusTimer.get(), SIGNAL(timeout()), this, SLOT(sendCanDataToServer()));
-    connect(batteryTimer.get(), SIGNAL(timeout()), this, SLOT(readBatteryData()));
+    connect(metricsTimer.get(), SIGNAL(timeout()), this, SLOT(dumpMetrics()));
+
+    dbusSendLatency = &metrics->histogram("canreceiver_dbus_send_seconds",
+                                          "Time to marshal and queue one saveCanDataInServer call.");
+    sensorDelay = &metrics->histogram("canreceiver_sensor_delay_seconds",
+                                      "Sender sampling to kernel RX of stamped frames, above the minimum.");
+    metrics->addCollector([this](MetricsWriter &writer) { collectMetrics(writer); });
+
+    filter.setDeadband(FieldRpm, PUBLISH_DEADBAND_RPM);
+    filter.setDeadband(FieldTemp, PUBLISH_DEADBAND_TEMP);
+    filter.setDeadband(FieldHum, PUBLISH_DEADBAND_HUM);
+    filter.setDeadband(FieldBattery, PUBLISH_DEADBAND_BATTERY);
+    filter.setHeartbeat(qint64(PUBLISH_HEARTBEAT_MS) * 1000000);
 }
 
 CanReceiver::CanReceiver(const CanReceiver &origin)
-    : QObject{this->parent()}, socketFD(origin.socketFD), canFrame(origin.canFrame)
+    : QObject{this->parent()}, buses(origin.buses), canData(origin.canData),
+      battery(origin.battery), batteryThread(origin.batteryThread)
 {
 }
 
@@ -34,144 +41,362 @@ CanReceiver &CanReceiver::operator=(const CanReceiver &origin)
 {
     if (this != &origin)
     {
-        socketFD = origin.socketFD;
-        canFrame = origin.canFrame;
+        buses = origin.buses;
+        battery = origin.battery;
+        batteryThread = origin.batteryThread;
     }
     return *this;
 }
 
 CanReceiver::~CanReceiver()
 {
-    if (socketFD > 0)
-        close(socketFD);
+    // Copies share the workers; only the last owner stops their threads.
+    for (Bus &bus : buses)
+    {
+        if (bus.thread.use_count() == 1)
+        {
+            bus.thread->quit();
+            bus.thread->wait();
+        }
+    }
+    if (batteryThread.use_count() == 1)
+    {
+        batteryThread->quit();
+        batteryThread->wait();
+    }
 }
 
-void CanReceiver::initSocket(const QString &ifname)
+bool CanReceiver::enableRecorder(const QString &dir)
 {
-    socketFD = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if (socketFD < 0)
+    recorder = std::make_shared<FlightRecorder>();
+    if (!recorder->open(dir.toStdString()))
     {
-        qDebug() << COLOR_BRED << "Failed to socket create" << COLOR_RESET;
-        exit(socketFD);
+        LOG_ERROR("Failed to open flight recorder : %s", qPrintable(dir));
+        recorder.reset();
+        return false;
     }
-    qDebug() << COLOR_BGREEN << "Success to socket create" << COLOR_RESET;
+    LOG_INFO("Success to open flight recorder : %s", qPrintable(dir));
+    return true;
+}
 
-    struct ifreq ifr;
-    strcpy(ifr.ifr_name, ifname.toStdString().c_str());
-    int ret = ioctl(socketFD, SIOCGIFINDEX, &ifr);
-    if (ret < 0)
+bool CanReceiver::addBus(const QString &ifname, const QString &table)
+{
+    if (buses.size() >= CAN_MAX_BUSES)
     {
-        qDebug() << COLOR_BRED << "Failed to get CAN interface index" << COLOR_RESET;
-        exit(ret);
+        LOG_ERROR("Too many CAN interfaces, at most %d", CAN_MAX_BUSES);
+        return false;
     }
-    qDebug() << COLOR_BGREEN << "Success to get CAN interface index : " << ret << COLOR_RESET;
-
-    struct sockaddr_can addr;
-    addr.can_family = AF_CAN;
-    addr.can_ifindex = ifr.ifr_ifindex;
-    ret = bind(socketFD, (struct sockaddr *)&addr, sizeof(addr));
-    if (ret < 0)
+    const CanSignalTable *signalTable = findSignalTable(table.toStdString().c_str());
+    if (!signalTable)
     {
-        qDebug() << COLOR_BRED << "Failed to socket bind" << COLOR_RESET;
-        qDebug() << COLOR_RED << "Error code : " << ret << COLOR_RESET;
-        exit(ret);
+        LOG_ERROR("Unknown signal table : %s", qPrintable(table));
+        return false;
     }
-    qDebug() << COLOR_BGREEN << "Success to socket bind" << COLOR_RESET;
+
+    Bus bus;
+    bus.reader = std::make_shared<CanReader>(uint8_t(buses.size()), signalTable->entries,
+                                             signalTable->count);
+    bus.reader->setRecorder(recorder);
+    bus.reader->setDelayHistogram(sensorDelay);
+    if (!bus.reader->open(ifname))
+        return false;
+    LOG_INFO("CAN bus %zu : %s, table %s", buses.size(), qPrintable(ifname), signalTable->name);
+
+    bus.thread = std::make_shared<QThread>();
+    bus.thread->setObjectName("can-" + ifname);
+    bus.reader->setWakeup(&wakeup);
+    bus.reader->moveToThread(bus.thread.get());
+    // finished() is emitted on the reader thread as its event loop ends.
+    connect(bus.thread.get(), SIGNAL(finished()), bus.reader.get(), SLOT(stop()), Qt::DirectConnection);
+    bus.reportedOverflows = 0;
+    bus.reportedDrops = 0;
+    buses.push_back(bus);
+    return true;
 }
 
-int CanReceiver::readData()
+// Moves every sample queued by the reader threads into canData, oldest
+// first across all buses, so a value carried on two buses ends with the
+// newer one. Runs on the publisher thread, the only consumer of the rings.
+int CanReceiver::drainSamples()
 {
-    int rd_byte = read(socketFD, &canFrame, sizeof(canFrame));
-    if (rd_byte < 0)
+    int samples = 0;
+    CanSample sample;
+
+    for (;;)
     {
-        qDebug() << COLOR_BRED << "Failed to recieve CAN frame" << COLOR_RESET;
-        return rd_byte;
-    }
+        Bus *oldest = nullptr;
+        int64_t oldestStamp = 0;
+        for (Bus &bus : buses)
+        {
+            const CanSample *head = bus.reader->peekSample();
+            if (head && (!oldest || head->stampNs < oldestStamp))
+            {
+                oldest = &bus;
+                oldestStamp = head->stampNs;
+            }
+        }
+        if (!oldest || !oldest->reader->takeSample(sample))
+            break;
 
-    std::cout << "ID =>[0x" << std::hex << canFrame.can_id << "] | size{" << int(canFrame.can_dlc) << "}" << std::endl;
+        for (int field = 0; field < FieldCount; field++)
+        {
+            if (sample.fields & DATA_FIELD_BIT(field))
+                canData.field(field) = sample.values.field(field);
+        }
+        canData.stamp = sample.stampNs;
+        samples++;
 
-    for (int i = 0; i < canFrame.can_dlc; i++)
-        std::cout << std::hex << int(canFrame.data[i]) << " : ";
-    std::cout << std::endl;
+        LOG_DEBUG("bus %d ID =>[0x%x] | fields{%x} | RPM : %d", sample.bus, sample.canId,
+                  sample.fields, canData.rpm);
+    }
 
-    int rpm = (canFrame.data[0] * 256) + canFrame.data[1];
+    for (Bus &bus : buses)
+        reportLosses(bus);
 
-    std::cout << "RPM : " << std::dec << rpm << std::endl;
+    return samples;
+}
 
-    return rd_byte;
+void CanReceiver::reportLosses(Bus &bus)
+{
+    const CanReader &reader = *bus.reader;
+    if (reader.ringOverflows() == bus.reportedOverflows && reader.kernelDrops() == bus.reportedDrops)
+        return;
+    bus.reportedOverflows = reader.ringOverflows();
+    bus.reportedDrops = reader.kernelDrops();
+    LOG_WARN("CAN samples lost on %s, ring overflows : %llu kernel drops : %llu",
+             qPrintable(reader.interfaceName()), (unsigned long long)bus.reportedOverflows,
+             (unsigned long long)bus.reportedDrops);
 }
 
 void CanReceiver::initDBusServer(const QString &serverName, const QString &objName)
 {
-    dataManager = new local::DataManager(serverName, objName,
-                                         QDBusConnection::sessionBus(), this);
-    qDebug() << COLOR_BGREEN << "Success to open Dbus server" << COLOR_RESET;
+    dataManagerService = serverName;
+    dataManagerPath = objName;
+    openDataManager();
+
+    serviceWatcher = new QDBusServiceWatcher(serverName, QDBusConnection::sessionBus(),
+                                             QDBusServiceWatcher::WatchForRegistration, this);
+    connect(serviceWatcher, SIGNAL(serviceRegistered(QString)), this, SLOT(serverRestarted()));
 }
 
-void CanReceiver::startCommunicate()
+void CanReceiver::openDataManager()
 {
-    int intervals = 10;
-    inaStatus = initBatteryLine();
+    delete dataManager;
+    QDBusConnection connection = connectDataManager(dataManagerConnectionName("canreceiver", this),
+                                                    dataManagerPeer);
+    dataManager = new local::DataManager(dataManagerPeer ? QString() : dataManagerService,
+                                         dataManagerPath, connection, this);
+    LOG_INFO("Success to open Dbus server : %s", dataManagerPeer ? "peer" : "session bus");
+}
 
-    canTimer->start(intervals);
-    dbusTimer->start(intervals);
-    batteryTimer->start(5000);
+// A peer connection ends with the server that accepted it; the new one
+// registering its name is the cue to connect again.
+void CanReceiver::serverRestarted()
+{
+    openDataManager();
 }
 
-int CanReceiver::initBatteryLine()
+// Exports local.Metrics on the session bus and, when dumpPath is not
+// empty, rewrites a Prometheus text file there every few seconds.
+bool CanReceiver::initMetrics(const QString &dumpPath)
 {
-    ina219 = ina219_create(I2C_DEV, I2C_ADDR, SHUNT_MILLIOHMS,
-                           BATTERY_VOLTAGE_0_PERCENT, BATTERY_VOLTAGE_100_PERCENT,
-                           BATTERY_CAPACITY, MIN_CHARGING_CURRENT);
-    char *error = NULL;
-    if (!ina219_init(ina219, &error))
+    new MetricsAdaptor(this);
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    if (!connection.registerObject(METRICS_OBJECT, this) || !connection.registerService(METRICS_SERVICE))
     {
-        qDebug() << QString("Battery line init fail %1").arg(error);
-        return 0;
+        LOG_ERROR("Failed to export metrics : %s", qPrintable(connection.lastError().message()));
+        return false;
     }
-    qDebug() << COLOR_BGREEN << "Success to battery line init" << COLOR_RESET;
-    return 1;
+    LOG_INFO("Success to export metrics : %s", METRICS_SERVICE);
+
+    metricsPath = dumpPath;
+    if (!metricsPath.isEmpty())
+        metricsTimer->start(METRICS_DUMP_INTERVAL_MS);
+    return true;
 }
 
-void CanReceiver::sendCanDataToServer()
+void CanReceiver::collectMetrics(MetricsWriter &writer) const
 {
-    if (socketFD < 0)
+    // Series of one family must be adjacent, so each metric loops over
+    // the buses rather than each bus over the metrics.
+    std::vector<std::string> labels;
+    for (const Bus &bus : buses)
+        labels.push_back(QString("bus=\"%1\"").arg(bus.reader->interfaceName()).toStdString());
+
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_frames_received_total", "CAN frames read from the socket.",
+                       buses[i].reader->framesReceived(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_wire_bits_total", "Nominal CAN bits on the wire; rate over bitrate is the bus load.",
+                       buses[i].reader->wireBits(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
     {
-        qDebug() << COLOR_BRED << "CAN socket is not open" << COLOR_RESET;
-        return;
+        const CanReader &reader = *buses[i].reader;
+        for (canid_t id = 0; id <= CAN_SFF_MASK; id++)
+        {
+            uint64_t frames = reader.framesForId(id);
+            if (frames)
+                writer.counter("can_frames_by_id_total", "CAN frames read per identifier.", frames,
+                               labels[i] + QString(",can_id=\"0x%1\"").arg(id, 3, 16, QChar('0')).toStdString());
+        }
+        if (reader.extendedFrames())
+            writer.counter("can_frames_by_id_total", "CAN frames read per identifier.",
+                           reader.extendedFrames(), labels[i] + ",can_id=\"extended\"");
     }
-    if (!dataManager)
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_read_errors_total", "Failed CAN socket reads.",
+                       buses[i].reader->readErrors(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_decode_failures_total", "CAN frames without a known signal.",
+                       buses[i].reader->decodeFailures(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_sample_ring_overflows_total", "Decoded samples dropped on a full ring.",
+                       buses[i].reader->ringOverflows(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_kernel_drops_total", "Frames dropped by the kernel socket queue.",
+                       buses[i].reader->kernelDrops(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_sequenced_frames_total", "Frames carrying a sequence number.",
+                       buses[i].reader->sequencedFrames(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_sequence_lost_total", "Sequence numbers skipped by the sender or the bus.",
+                       buses[i].reader->sequenceLost(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_sequence_late_total", "Frames dropped for arriving after a newer one.",
+                       buses[i].reader->sequenceLate(), labels[i]);
+    for (size_t i = 0; i < buses.size(); i++)
+        writer.counter("can_unsupported_version_total", "Frames of an unknown protocol version.",
+                       buses[i].reader->unsupportedVersions(), labels[i]);
+    writer.counter("canreceiver_publishes_total", "Publish decisions by outcome.",
+                   filter.publishedCount(), "result=\"sent\"");
+    writer.counter("canreceiver_publishes_total", "Publish decisions by outcome.",
+                   filter.suppressedCount(), "result=\"suppressed\"");
+    writer.counter("canreceiver_heartbeats_total", "Publishes sent only as a heartbeat.",
+                   filter.heartbeatCount());
+    writer.gauge("canreceiver_dbus_peer", "1 if publishing over the peer socket, 0 over the bus.",
+                 dataManagerPeer ? 1 : 0);
+    if (battery)
     {
-        qDebug() << COLOR_BRED << "D-Bus session is not open" << COLOR_RESET;
-        return;
+        writer.counter("canreceiver_i2c_read_errors_total", "INA219 status reads that failed.",
+                       battery->readErrors());
+        BatteryStatus status;
+        if (battery->latest(status))
+        {
+            writer.gauge("battery_voltage_millivolts", "Last INA219 bus voltage.", status.voltageMv);
+            writer.gauge("battery_current_milliamps", "Last shunt current, positive when charging.",
+                         status.currentMa);
+            writer.gauge("battery_soc_percent", "Estimated state of charge.", status.percent);
+            writer.gauge("battery_minutes_remaining", "Estimated time to full or empty.",
+                         status.minutes);
+        }
     }
-    canData->rpm = (canFrame.data[0] * 256) + canFrame.data[1];
-    canData->temp = canFrame.data[2];
-    canData->hum = canFrame.data[3];
-    QVariant v;
-    v.setValue(*canData);
-    QDBusVariant da;
-    da.setVariant(v);
-    dataManager->saveCanDataInServer(da);
 }
 
-void CanReceiver::readBatteryData()
+QString CanReceiver::fetchMetrics()
+{
+    return QString::fromStdString(metrics->prometheusText());
+}
+
+void CanReceiver::dumpMetrics()
+{
+    if (!metrics->dump(metricsPath.toStdString()))
+        LOG_ERROR("Failed to write metrics : %s", qPrintable(metricsPath));
+}
+
+void CanReceiver::startCommunicate()
 {
-    int mV;
-    int percent_charged;
-    int battery_current_mA;
-    int minutes;
-    INA219ChargeStatus charge_status;
-    char *error;
-    if (inaStatus == 1 &&
-            ina219_get_status(ina219, &charge_status,
-                              &mV, &percent_charged, &battery_current_mA,
-                              &minutes, &error))
+    // Samples are published as soon as a reader queues them; the timer is
+    // left with the heartbeat, checked often enough to keep its period.
+    int intervals = PUBLISH_HEARTBEAT_MS / 4;
+    if (wakeup.open())
     {
-        canData->battery = percent_charged;
+        wakeNotifier = std::make_shared<QSocketNotifier>(wakeup.fd(), QSocketNotifier::Read);
+        connect(wakeNotifier.get(), SIGNAL(activated(int)), this, SLOT(samplesReady()));
     }
     else
     {
-        qDebug() << COLOR_BRED << "Failed to get battery : " << error << COLOR_RESET;
+        LOG_WARN("Publish wakeup unavailable, polling every %d ms", PUBLISH_INTERVAL_MS);
+        intervals = PUBLISH_INTERVAL_MS;
     }
+    initBatteryLine();
+
+    for (Bus &bus : buses)
+    {
+        bus.thread->start();
+        QMetaObject::invokeMethod(bus.reader.get(), "start", Qt::QueuedConnection);
+    }
+    if (battery)
+    {
+        batteryThread->start();
+        QMetaObject::invokeMethod(battery.get(), "start", Qt::QueuedConnection);
+    }
+    dbusTimer->start(intervals);
+}
+
+// The INA219 is sampled on its own thread; without one the battery field
+// simply stays at its last value.
+void CanReceiver::initBatteryLine()
+{
+    battery = std::make_shared<BatteryMonitor>();
+    if (!battery->open())
+    {
+        battery.reset();
+        return;
+    }
+    battery->setInterval(batteryInterval);
+    battery->setLatencyHistogram(&metrics->histogram("canreceiver_i2c_read_seconds",
+                                                     "Duration of one INA219 status read."));
+
+    batteryThread = std::make_shared<QThread>();
+    batteryThread->setObjectName("battery");
+    battery->setWakeup(&wakeup);
+    battery->moveToThread(batteryThread.get());
+    connect(batteryThread.get(), SIGNAL(finished()), battery.get(), SLOT(stop()), Qt::DirectConnection);
+}
+
+void CanReceiver::samplesReady()
+{
+    wakeup.consume();
+    sendCanDataToServer();
+}
+
+// Picks up the worker's latest reading if it published a new one.
+void CanReceiver::takeBatteryStatus()
+{
+    if (!battery || battery->version() == batteryVersion)
+        return;
+    batteryVersion = battery->version();
+
+    BatteryStatus status;
+    if (battery->latest(status))
+        canData.battery = status.percent;
+}
+
+void CanReceiver::sendCanDataToServer()
+{
+    ALLOC_STAGE(AllocStageCanPublish);
+    if (buses.empty())
+    {
+        LOG_ERROR("CAN socket is not open");
+        return;
+    }
+    if (!dataManager)
+    {
+        LOG_ERROR("D-Bus session is not open");
+        return;
+    }
+    drainSamples();
+    takeBatteryStatus();
+
+    // Only real changes, or a heartbeat, are worth a D-Bus round trip.
+    uint64_t heartbeats = filter.heartbeatCount();
+    if (!filter.check(canData, currentTimeNs()))
+        return;
+    if (filter.heartbeatCount() != heartbeats)
+        LOG_INFO("Publish heartbeat, sent : %llu suppressed : %llu",
+                 (unsigned long long)filter.publishedCount(), (unsigned long long)filter.suppressedCount());
+
+    int64_t sendStart = currentTimeNs();
+    dataManager->saveCanDataInServer(filter.sent());
+    dbusSendLatency->record(currentTimeNs() - sendStart);
 }
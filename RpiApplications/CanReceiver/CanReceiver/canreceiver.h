@@ -3,34 +3,30 @@
 
 #include <QObject>
 #include <linux/can.h>
+#include <vector>
+#include "batterymonitor.h"
+#include "canreader.h"
+#include "pipelinemetrics.h"
+#include "printutils.h"
+#include "publishwakeup.h"
+#include "publishfilter.h"
 #include "datamanager_interface.h"
 
-# define COLOR_RED		"\x1b[31m"
-# define COLOR_GREEN	"\x1b[32m"
-# define COLOR_YELLOW	"\x1b[33m"
-# define COLOR_BLUE		"\x1b[34m"
-# define COLOR_MAGENTA	"\x1b[35m"
-# define COLOR_CYAN		"\x1b[36m"
-# define COLOR_WHITE	"\x1b[37m"
-# define COLOR_BRED		"\x1b[91m"
-# define COLOR_BGREEN	"\x1b[92m"
-# define COLOR_BYELLOW	"\x1b[93m"
-# define COLOR_BBLUE	"\x1b[94m"
-# define COLOR_BMAGENTA	"\x1b[95m"
-# define COLOR_BCYAN	"\x1b[96m"
-# define COLOR_RESET	"\x1b[0m"
-
-# define CAN_FRAME_MAX_LEN 8
-
-#define I2C_ADDR 0x42
-#define I2C_DEV "/dev/i2c-1"
-#define BATTERY_VOLTAGE_100_PERCENT 8400
-#define BATTERY_VOLTAGE_0_PERCENT 6000
-#define BATTERY_CAPACITY 2400
-#define MIN_CHARGING_CURRENT 10
-#define SHUNT_MILLIOHMS 100
-
-typedef struct _INA219 INA219;
+// Poll period of the publisher, only used if the wakeup eventfd cannot
+// be created; normally it runs as soon as a worker has new data.
+#define PUBLISH_INTERVAL_MS 10
+#define PUBLISH_HEARTBEAT_MS 1000
+#define PUBLISH_DEADBAND_RPM 5
+#define PUBLISH_DEADBAND_TEMP 0
+#define PUBLISH_DEADBAND_HUM 0
+#define PUBLISH_DEADBAND_BATTERY 1
+
+#define METRICS_SERVICE "pi.chan.canreceiver"
+#define METRICS_OBJECT "/metrics"
+#define METRICS_DUMP_INTERVAL_MS 5000
+
+// Bus indices are stored in one byte of every sample and flight record.
+#define CAN_MAX_BUSES 8
 
 class CanReceiver : public QObject
 {
@@ -42,30 +38,69 @@ public:
     CanReceiver &operator=(CanReceiver const &origin);
     ~CanReceiver();
 
-    void initSocket(const QString &ifname);
+    bool enableRecorder(const QString &dir);
+    // Opens one more bus, decoded with the named signal table. Every bus
+    // gets its own reader thread and sample ring.
+    bool addBus(const QString &ifname, const QString &table);
+    // Publishes over the server's peer socket when it offers one, else over
+    // the session bus; serverName is still watched there for restarts.
     void initDBusServer(const QString &serverName, const QString &objName);
+    bool initMetrics(const QString &dumpPath);
+    // Before startCommunicate().
+    void setBatteryInterval(int ms) { batteryInterval = ms; }
 
     void startCommunicate();
 
+    const PublishFilter &publishFilter() const { return filter; }
+
 private:
-    int socketFD;
-    struct can_frame canFrame;
-    struct Data *canData;
-    int inaStatus;
-    INA219 *ina219;
+    struct Bus {
+        std::shared_ptr<CanReader> reader;
+        std::shared_ptr<class QThread> thread;
+        uint64_t reportedOverflows;
+        uint64_t reportedDrops;
+    };
+
+    std::vector<Bus> buses;
+    std::shared_ptr<FlightRecorder> recorder;
+    struct Data canData;
+    PublishFilter filter;
+    std::shared_ptr<BatteryMonitor> battery;
+    std::shared_ptr<class QThread> batteryThread;
+    uint32_t batteryVersion;
+    int batteryInterval;
     local::DataManager *dataManager;
-    std::shared_ptr<class QTimer> canTimer;
+    QString dataManagerService;
+    QString dataManagerPath;
+    bool dataManagerPeer;
+    class QDBusServiceWatcher *serviceWatcher;
+    // Heartbeat only, unless the wakeup is unavailable.
     std::shared_ptr<class QTimer> dbusTimer;
-    std::shared_ptr<class QTimer> batteryTimer;
+    PublishWakeup wakeup;
+    std::shared_ptr<class QSocketNotifier> wakeNotifier;
+    std::shared_ptr<class QTimer> metricsTimer;
+    std::shared_ptr<PipelineMetrics> metrics;
+    LatencyHistogram *dbusSendLatency;
+    LatencyHistogram *sensorDelay;
+    QString metricsPath;
 
-    int initBatteryLine();
+    void initBatteryLine();
+    void openDataManager();
+    int drainSamples();
+    void reportLosses(Bus &bus);
+    void takeBatteryStatus();
+    void collectMetrics(MetricsWriter &writer) const;
 
 signals:
 
 public slots:
-    int readData();
     void sendCanDataToServer();
-    void readBatteryData();
+    QString fetchMetrics();
+    void dumpMetrics();
+
+private slots:
+    void serverRestarted();
+    void samplesReady();
 
 };
 
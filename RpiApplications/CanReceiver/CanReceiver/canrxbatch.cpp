@@ -0,0 +1,97 @@
+#include <errno.h>
+#include <string.h>
+#include "canrxbatch.h"
+
+CanRxBatch::CanRxBatch()
+    : count(0), drops(0)
+{
+    memset(frames, 0, sizeof(frames));
+    memset(stamps, 0, sizeof(stamps));
+    for (int i = 0; i < CAN_RX_BATCH; i++)
+    {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+    }
+    rearm();
+}
+
+int CanRxBatch::enableTimestamps(int socketFD)
+{
+    int on = 1;
+    return setsockopt(socketFD, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+}
+
+int CanRxBatch::enableDropCounter(int socketFD)
+{
+    int on = 1;
+    return setsockopt(socketFD, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+}
+
+void CanRxBatch::rearm()
+{
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < CAN_RX_BATCH; i++)
+    {
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+}
+
+// Returns the number of frames received, 0 when the queue is empty and -1
+// on a real socket error (errno is preserved).
+int CanRxBatch::receive(int socketFD)
+{
+    int ret;
+    do
+        ret = recvmmsg(socketFD, msgs, CAN_RX_BATCH, MSG_DONTWAIT, NULL);
+    while (ret < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        count = 0;
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t fallback = int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+    count = 0;
+    for (int i = 0; i < ret; i++)
+    {
+        if (msgs[i].msg_len == CANFD_MTU)
+            frames[i].flags |= CANFD_FDF;
+        else if (msgs[i].msg_len == CAN_MTU)
+            frames[i].flags = 0;
+        else
+            continue;
+
+        int64_t stampNs = fallback;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg;
+             cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS)
+            {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                stampNs = int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+            }
+            else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+                memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            }
+        }
+
+        if (count != i)
+            frames[count] = frames[i];
+        stamps[count++] = stampNs;
+    }
+
+    // recvmmsg() overwrites msg_controllen with the length it used.
+    for (int i = 0; i < ret; i++)
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+
+    return count;
+}
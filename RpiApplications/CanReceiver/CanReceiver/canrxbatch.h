@@ -0,0 +1,53 @@
+#ifndef CANRXBATCH_H
+#define CANRXBATCH_H
+
+#include <linux/can.h>
+#include <sys/socket.h>
+#include <stdint.h>
+#include <time.h>
+
+# define CAN_RX_BATCH 32
+
+// Set by newer kernels on received CAN FD frames; older ones leave it to us.
+#ifndef CANFD_FDF
+# define CANFD_FDF 0x04
+#endif
+
+// Preallocated receive window for recvmmsg(). One receive() call moves up
+// to CAN_RX_BATCH frames out of the socket queue, each paired with the
+// kernel RX timestamp (SO_TIMESTAMPNS, CLOCK_REALTIME nanoseconds). With
+// SO_RXQ_OVFL enabled, kernelDrops() follows the socket's cumulative count
+// of frames dropped because the receive queue was full.
+//
+// Frames are held as canfd_frame. A classic frame occupies the same leading
+// bytes, and with CAN_RAW_FD_FRAMES enabled the socket delivers both kinds;
+// frame(i).flags has CANFD_FDF set for the FD ones.
+class CanRxBatch
+{
+public:
+    CanRxBatch();
+
+    static int enableTimestamps(int socketFD);
+    static int enableDropCounter(int socketFD);
+
+    int receive(int socketFD);
+
+    int size() const { return count; }
+    bool full() const { return count == CAN_RX_BATCH; }
+    const struct canfd_frame &frame(int i) const { return frames[i]; }
+    int64_t stamp(int i) const { return stamps[i]; }
+    uint32_t kernelDrops() const { return drops; }
+
+private:
+    struct canfd_frame frames[CAN_RX_BATCH];
+    int64_t stamps[CAN_RX_BATCH];
+    struct iovec iov[CAN_RX_BATCH];
+    struct mmsghdr msgs[CAN_RX_BATCH];
+    char control[CAN_RX_BATCH][CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))];
+    int count;
+    uint32_t drops;
+
+    void rearm();
+};
+
+#endif // CANRXBATCH_H
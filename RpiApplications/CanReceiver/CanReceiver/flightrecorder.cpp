@@ -0,0 +1,457 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include "flightrecorder.h"
+
+static size_t pageAlign(size_t value)
+{
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    return (value + page - 1) / page * page;
+}
+
+// Faults every page of a shared file mapping in writable, here on the
+// helper thread, so the recording thread never takes a fault that waits on
+// the disk. MAP_POPULATE is not enough: on a MAP_SHARED file mapping it
+// only maps the pages read-only and the first store still faults.
+static void prefaultWritable(void *base, size_t size)
+{
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(base, size, MADV_POPULATE_WRITE) == 0)
+        return;
+#endif
+    // Kernels before 5.14: dirty one byte per page. The file was just
+    // allocated, so every byte is already zero.
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    volatile char *bytes = static_cast<volatile char *>(base);
+    for (size_t offset = 0; offset < size; offset += page)
+        bytes[offset] = 0;
+}
+
+static bool parseSegmentName(const char *name, uint32_t &sequence)
+{
+    unsigned int value;
+    char tail;
+    if (sscanf(name, "can-%8u.re%c", &value, &tail) != 2 || tail != 'c' || strlen(name) != 16)
+        return false;
+    sequence = value;
+    return true;
+}
+
+std::vector<std::string> listFlightSegments(const std::string &dir)
+{
+    std::vector<std::pair<uint32_t, std::string> > found;
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+        return std::vector<std::string>();
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL)
+    {
+        uint32_t sequence;
+        if (parseSegmentName(entry->d_name, sequence))
+            found.push_back(std::make_pair(sequence, dir + "/" + entry->d_name));
+    }
+    closedir(d);
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < found.size(); i++)
+        paths.push_back(found[i].second);
+    return paths;
+}
+
+FlightSegment::FlightSegment()
+    : sequence(0), fd(-1), base(nullptr), mapSize(0),
+      header(nullptr), index(nullptr), records(nullptr), recordSize(sizeof(FlightRecord))
+{
+}
+
+FlightRecorder::FlightRecorder()
+    : recordsPerSegment(FLIGHT_SEGMENT_RECORDS), maxSegments(FLIGHT_MAX_SEGMENTS),
+      nextSequence(0), spareReady(false), retiredPending(false), stopping(false),
+      recorded(0), dropped(0)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+bool FlightRecorder::open(const std::string &dir, uint32_t recordsPerSegment, int maxSegments)
+{
+    close();
+
+    mkdir(dir.c_str(), 0755);
+    this->dir = dir;
+    this->recordsPerSegment = std::max<uint32_t>(recordsPerSegment, FLIGHT_INDEX_STRIDE);
+    this->maxSegments = std::max(maxSegments, 2);
+
+    nextSequence = 0;
+    std::vector<std::string> existing = listFlightSegments(dir);
+    if (!existing.empty())
+    {
+        uint32_t last;
+        const char *name = strrchr(existing.back().c_str(), '/') + 1;
+        if (parseSegmentName(name, last))
+            nextSequence = last + 1;
+    }
+
+    if (!createSegment(nextSequence++, current))
+        return false;
+
+    stopping = false;
+    helper = std::thread(&FlightRecorder::helperLoop, this);
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if (helper.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        helper.join();
+    }
+
+    if (retiredPending.exchange(false))
+        finishSegment(retired);
+    if (spareReady.exchange(false))
+    {
+        std::string path = spare.path;
+        spare.header->count.store(0);
+        finishSegment(spare);
+        unlink(path.c_str());
+    }
+    if (current.header)
+        finishSegment(current);
+}
+
+bool FlightRecorder::createSegment(uint32_t sequence, FlightSegment &segment)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "can-%08u.rec", sequence);
+    segment.path = dir + "/" + name;
+    segment.sequence = sequence;
+
+    uint32_t indexEntries = (recordsPerSegment + FLIGHT_INDEX_STRIDE - 1) / FLIGHT_INDEX_STRIDE;
+    size_t recordsOffset = pageAlign(sizeof(FlightSegmentHeader) + indexEntries * sizeof(FlightIndexEntry));
+    segment.mapSize = recordsOffset + size_t(recordsPerSegment) * sizeof(FlightRecord);
+
+    segment.fd = ::open(segment.path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (segment.fd < 0)
+        return false;
+    if (posix_fallocate(segment.fd, 0, segment.mapSize) != 0)
+    {
+        ::close(segment.fd);
+        unlink(segment.path.c_str());
+        segment.fd = -1;
+        return false;
+    }
+
+    segment.base = mmap(NULL, segment.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, 0);
+    if (segment.base == MAP_FAILED)
+    {
+        ::close(segment.fd);
+        unlink(segment.path.c_str());
+        segment.fd = -1;
+        segment.base = nullptr;
+        return false;
+    }
+    prefaultWritable(segment.base, segment.mapSize);
+
+    char *bytes = static_cast<char *>(segment.base);
+    segment.header = new (bytes) FlightSegmentHeader();
+    segment.header->magic = FLIGHT_MAGIC;
+    segment.header->version = FLIGHT_VERSION;
+    segment.header->recordSize = sizeof(FlightRecord);
+    segment.header->capacity = recordsPerSegment;
+    segment.header->indexStride = FLIGHT_INDEX_STRIDE;
+    segment.header->recordsOffset = uint32_t(recordsOffset);
+    segment.header->sequence = sequence;
+    segment.header->count.store(0, std::memory_order_release);
+    segment.index = reinterpret_cast<FlightIndexEntry *>(bytes + sizeof(FlightSegmentHeader));
+    segment.records = reinterpret_cast<FlightRecord *>(bytes + recordsOffset);
+    return true;
+}
+
+// Flushes asynchronously and trims the preallocated tail of the file.
+void FlightRecorder::finishSegment(FlightSegment &segment)
+{
+    if (!segment.header)
+        return;
+
+    size_t used = segment.header->recordsOffset +
+            size_t(segment.header->count.load(std::memory_order_acquire)) * sizeof(FlightRecord);
+    msync(segment.base, segment.mapSize, MS_ASYNC);
+    munmap(segment.base, segment.mapSize);
+    if (ftruncate(segment.fd, used) < 0)
+        perror("flight recorder trim");
+    ::close(segment.fd);
+    segment = FlightSegment();
+}
+
+void FlightRecorder::pruneSegments()
+{
+    std::vector<std::string> paths = listFlightSegments(dir);
+    for (int i = 0; i + maxSegments < int(paths.size()); i++)
+        unlink(paths[i].c_str());
+}
+
+void FlightRecorder::helperLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        lock.unlock();
+        if (retiredPending.load(std::memory_order_acquire))
+        {
+            finishSegment(retired);
+            retiredPending.store(false, std::memory_order_release);
+        }
+        if (!spareReady.load(std::memory_order_acquire))
+        {
+            if (createSegment(nextSequence, spare))
+            {
+                nextSequence++;
+                spareReady.store(true, std::memory_order_release);
+                pruneSegments();
+            }
+        }
+        lock.lock();
+
+        // The recording thread notifies without the lock; the timeout
+        // bounds a missed wakeup.
+        wake.wait_for(lock, std::chrono::milliseconds(100));
+    }
+}
+
+bool FlightRecorder::roll()
+{
+    if (!spareReady.load(std::memory_order_acquire) ||
+            retiredPending.load(std::memory_order_acquire))
+        return false;
+
+    retired = current;
+    current = spare;
+    spare = FlightSegment();
+    spareReady.store(false, std::memory_order_release);
+    retiredPending.store(true, std::memory_order_release);
+    wake.notify_one();
+    return true;
+}
+
+bool FlightRecorder::append(const struct canfd_frame &frame, int64_t stampNs, uint8_t bus)
+{
+    while (appendLock.test_and_set(std::memory_order_acquire))
+        ;
+    bool ok = appendLocked(frame, stampNs, bus);
+    appendLock.clear(std::memory_order_release);
+    return ok;
+}
+
+bool FlightRecorder::appendLocked(const struct canfd_frame &frame, int64_t stampNs, uint8_t bus)
+{
+    if (!current.header ||
+            (current.header->count.load(std::memory_order_relaxed) >= current.header->capacity && !roll()))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    FlightSegmentHeader *header = current.header;
+    uint32_t n = header->count.load(std::memory_order_relaxed);
+
+    FlightRecord &record = current.records[n];
+    record.stampNs = stampNs;
+    record.canId = frame.can_id;
+    record.len = frame.len > CANFD_MAX_DLEN ? CANFD_MAX_DLEN : frame.len;
+    record.flags = frame.flags;
+    record.bus = bus;
+    record.reserved = 0;
+    memcpy(record.data, frame.data, sizeof(record.data));
+
+    if (n == 0)
+        header->firstStampNs = stampNs;
+    if (n % FLIGHT_INDEX_STRIDE == 0)
+    {
+        current.index[n / FLIGHT_INDEX_STRIDE].stampNs = stampNs;
+        current.index[n / FLIGHT_INDEX_STRIDE].record = n;
+    }
+    header->lastStampNs = stampNs;
+    header->count.store(n + 1, std::memory_order_release);
+
+    recorded.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+FlightReader::FlightReader()
+    : segmentIndex(0), recordIndex(0)
+{
+}
+
+FlightReader::~FlightReader()
+{
+    close();
+}
+
+bool FlightReader::open(const std::string &dir)
+{
+    close();
+
+    std::vector<std::string> paths = listFlightSegments(dir);
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        FlightSegment segment;
+        segment.path = paths[i];
+        segment.fd = ::open(paths[i].c_str(), O_RDONLY);
+        if (segment.fd < 0)
+            continue;
+
+        struct stat st;
+        if (fstat(segment.fd, &st) < 0 || size_t(st.st_size) < sizeof(FlightSegmentHeader))
+        {
+            ::close(segment.fd);
+            continue;
+        }
+        segment.mapSize = size_t(st.st_size);
+        segment.base = mmap(NULL, segment.mapSize, PROT_READ, MAP_SHARED, segment.fd, 0);
+        if (segment.base == MAP_FAILED)
+        {
+            ::close(segment.fd);
+            continue;
+        }
+
+        char *bytes = static_cast<char *>(segment.base);
+        segment.header = reinterpret_cast<FlightSegmentHeader *>(bytes);
+        uint32_t recordSize = segment.header->recordSize;
+        bool known = (segment.header->version == 1 && recordSize == FLIGHT_V1_RECORD_SIZE) ||
+                (segment.header->version == FLIGHT_VERSION && recordSize == sizeof(FlightRecord));
+        if (segment.header->magic != FLIGHT_MAGIC || !known ||
+                segment.header->count.load(std::memory_order_acquire) == 0)
+        {
+            munmap(segment.base, segment.mapSize);
+            ::close(segment.fd);
+            continue;
+        }
+
+        // A trimmed file may be shorter than the capacity in its header.
+        size_t available = (segment.mapSize - segment.header->recordsOffset) / recordSize;
+        if (segment.header->count.load(std::memory_order_acquire) > available)
+        {
+            munmap(segment.base, segment.mapSize);
+            ::close(segment.fd);
+            continue;
+        }
+
+        segment.sequence = segment.header->sequence;
+        segment.index = reinterpret_cast<FlightIndexEntry *>(bytes + sizeof(FlightSegmentHeader));
+        segment.records = reinterpret_cast<FlightRecord *>(bytes + segment.header->recordsOffset);
+        segment.recordSize = recordSize;
+        segments.push_back(segment);
+    }
+
+    segmentIndex = 0;
+    recordIndex = 0;
+    return !segments.empty();
+}
+
+void FlightReader::close()
+{
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        munmap(segments[i].base, segments[i].mapSize);
+        ::close(segments[i].fd);
+    }
+    segments.clear();
+}
+
+int64_t FlightReader::firstStamp() const
+{
+    return segments.empty() ? 0 : segments.front().header->firstStampNs;
+}
+
+int64_t FlightReader::lastStamp() const
+{
+    return segments.empty() ? 0 : segments.back().header->lastStampNs;
+}
+
+uint64_t FlightReader::recordCount() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < segments.size(); i++)
+        total += segments[i].header->count.load(std::memory_order_acquire);
+    return total;
+}
+
+// Positions the reader on the first record at or after stampNs.
+bool FlightReader::seek(int64_t stampNs)
+{
+    size_t low = 0;
+    size_t high = segments.size();
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (segments[mid].header->lastStampNs < stampNs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    segmentIndex = low;
+    recordIndex = 0;
+    if (segmentIndex >= segments.size())
+        return false;
+
+    const FlightSegment &segment = segments[segmentIndex];
+    uint32_t count = segment.header->count.load(std::memory_order_acquire);
+    uint32_t entries = (count + segment.header->indexStride - 1) / segment.header->indexStride;
+
+    // Last index entry stamped before stampNs, then a short linear scan.
+    uint32_t lowEntry = 0;
+    uint32_t highEntry = entries;
+    while (lowEntry < highEntry)
+    {
+        uint32_t mid = (lowEntry + highEntry) / 2;
+        if (segment.index[mid].stampNs < stampNs)
+            lowEntry = mid + 1;
+        else
+            highEntry = mid;
+    }
+    recordIndex = lowEntry > 0 ? segment.index[lowEntry - 1].record : 0;
+    while (recordIndex < count && segment.record(recordIndex).stampNs < stampNs)
+        recordIndex++;
+    return true;
+}
+
+bool FlightReader::next(FlightRecord &record)
+{
+    while (segmentIndex < segments.size())
+    {
+        const FlightSegment &segment = segments[segmentIndex];
+        if (recordIndex < segment.header->count.load(std::memory_order_acquire))
+        {
+            // Older, shorter records leave the tail of the data zeroed.
+            if (segment.recordSize == sizeof(FlightRecord))
+            {
+                record = segment.record(recordIndex++);
+                return true;
+            }
+            memset(&record, 0, sizeof(record));
+            memcpy(&record, &segment.record(recordIndex++), segment.recordSize);
+            return true;
+        }
+        segmentIndex++;
+        recordIndex = 0;
+    }
+    return false;
+}
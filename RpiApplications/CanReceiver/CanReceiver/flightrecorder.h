@@ -0,0 +1,164 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Set by newer kernels on received CAN FD frames.
+#ifndef CANFD_FDF
+# define CANFD_FDF 0x04
+#endif
+
+#define FLIGHT_MAGIC 0x524e4143
+#define FLIGHT_VERSION 2
+// Version 1 records stopped after 8 data bytes; FlightReader still reads them.
+#define FLIGHT_V1_RECORD_SIZE 24
+// Segments are sized in bytes, so the disk budget (6 MB per segment,
+// 384 MB in total) does not grow with the record size.
+#define FLIGHT_SEGMENT_BYTES (6 * 1024 * 1024)
+#define FLIGHT_SEGMENT_RECORDS uint32_t(FLIGHT_SEGMENT_BYTES / sizeof(FlightRecord))
+#define FLIGHT_INDEX_STRIDE 256
+#define FLIGHT_MAX_SEGMENTS 64
+
+// Fixed-width record, one per raw CAN or CAN FD frame. flags are the
+// canfd_frame flags; CANFD_FDF marks an FD frame.
+struct FlightRecord {
+    int64_t stampNs;
+    uint32_t canId;
+    uint8_t len;
+    uint8_t flags;
+    uint8_t bus;
+    uint8_t reserved;
+    uint8_t data[CANFD_MAX_DLEN];
+};
+
+// Sparse time index: the stamp of every FLIGHT_INDEX_STRIDE-th record.
+struct FlightIndexEntry {
+    int64_t stampNs;
+    uint32_t record;
+    uint32_t reserved;
+};
+
+// First bytes of every segment file. The index follows the header and the
+// records start at recordsOffset (page aligned). count is published with
+// release ordering after each record, so a reader mapping a live segment
+// only ever sees complete records.
+struct FlightSegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t indexStride;
+    uint32_t recordsOffset;
+    uint32_t sequence;
+    std::atomic<uint32_t> count;
+    uint32_t reserved;
+    int64_t firstStampNs;
+    int64_t lastStampNs;
+};
+
+struct FlightSegment {
+    FlightSegment();
+
+    std::string path;
+    uint32_t sequence;
+    int fd;
+    void *base;
+    size_t mapSize;
+    FlightSegmentHeader *header;
+    FlightIndexEntry *index;
+    FlightRecord *records;
+    // Stride of records; older segments use shorter records.
+    uint32_t recordSize;
+
+    const FlightRecord &record(uint32_t i) const
+    {
+        return *reinterpret_cast<const FlightRecord *>(reinterpret_cast<const char *>(records) +
+                                                       size_t(i) * recordSize);
+    }
+};
+
+// Append-only recorder over preallocated, memory-mapped segment files
+// (<dir>/can-<sequence>.rec). append() only copies into mapped, prefaulted
+// memory; a helper thread creates the next segment ahead of time, retires
+// full ones (async msync, trim) and enforces the segment limit. If no
+// spare segment is ready the record is dropped rather than waiting.
+// Several bus readers may share one recorder; their appends serialize on a
+// spin lock held only for the copy.
+class FlightRecorder
+{
+public:
+    FlightRecorder();
+    ~FlightRecorder();
+
+    bool open(const std::string &dir, uint32_t recordsPerSegment = FLIGHT_SEGMENT_RECORDS,
+              int maxSegments = FLIGHT_MAX_SEGMENTS);
+    void close();
+
+    bool append(const struct canfd_frame &frame, int64_t stampNs, uint8_t bus = 0);
+
+    uint64_t recordedCount() const { return recorded.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::string dir;
+    uint32_t recordsPerSegment;
+    int maxSegments;
+    uint32_t nextSequence;
+
+    FlightSegment current;
+    FlightSegment spare;
+    FlightSegment retired;
+    std::atomic<bool> spareReady;
+    std::atomic<bool> retiredPending;
+    std::atomic_flag appendLock = ATOMIC_FLAG_INIT;
+
+    std::thread helper;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    std::atomic<uint64_t> recorded;
+    std::atomic<uint64_t> dropped;
+
+    bool appendLocked(const struct canfd_frame &frame, int64_t stampNs, uint8_t bus);
+    bool roll();
+    void helperLoop();
+    bool createSegment(uint32_t sequence, FlightSegment &segment);
+    void finishSegment(FlightSegment &segment);
+    void pruneSegments();
+};
+
+// Read side, used by the replay tool. Segments are mapped read-only;
+// seek() is a binary search over segments, then over the sparse index.
+class FlightReader
+{
+public:
+    FlightReader();
+    ~FlightReader();
+
+    bool open(const std::string &dir);
+    void close();
+
+    int64_t firstStamp() const;
+    int64_t lastStamp() const;
+    uint64_t recordCount() const;
+
+    bool seek(int64_t stampNs);
+    bool next(FlightRecord &record);
+
+private:
+    std::vector<FlightSegment> segments;
+    size_t segmentIndex;
+    uint32_t recordIndex;
+};
+
+std::vector<std::string> listFlightSegments(const std::string &dir);
+
+#endif // FLIGHTRECORDER_H
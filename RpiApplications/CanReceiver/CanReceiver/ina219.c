@@ -40,6 +40,7 @@ struct _INA219
   char *i2c_dev; // E.g., /dev/i2c-1
   int i2c_addr;  // E.g., 0x43
   int fd; // For the /dev/i2c-N device
+  BOOL combined; // Adapter accepts I2C_RDWR with a repeated start
   // The following are battery and system properties passed by the caller.
   int shunt_milliohms; 
   int battery_voltage_0_percent;
@@ -63,6 +64,11 @@ struct _INA219
   into this choice -- it just reduces the amount of ugly casting in 
   other parts of the code.
 
+  When the adapter supports plain I2C messages, the register write and the
+  data read go out as one I2C_RDWR transaction with a repeated start: one
+  system call per register, and no other bus master can slip in between
+  the two halves. Otherwise we fall back to a separate write() and read().
+
   This method can fail, but it's highly unlikely if _init() suceeded.  
 
 ============================================================================*/
@@ -74,8 +80,34 @@ static BOOL ina219_register_read_16 (const INA219 *self, BYTE reg,
   BOOL ret = FALSE;
   BYTE buff[2];
   buff[0] = reg;
+  if (self->combined)
+    {
+    struct i2c_msg msgs[2];
+    msgs[0].addr = self->i2c_addr;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = self->i2c_addr;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = 2;
+    msgs[1].buf = buff;
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = msgs;
+    transfer.nmsgs = 2;
+    if (ioctl (self->fd, I2C_RDWR, &transfer) == 2)
+      {
+      *data = (buff[0] << 8 ) | buff[1];
+      ret = TRUE;
+      }
+    else
+      {
+      if (error) asprintf (error, "Failed to transfer I2C device: %s\n", 
+        strerror (errno));
+      }
+    return ret;
+    }
   // Write the register number to the bus
-  if (write (self->fd, &buff, 1))
+  if (write (self->fd, &buff, 1) == 1)
     {
     // Then read the two-byte result
     if (read (self->fd, buff, 2) == 2)
@@ -143,6 +175,28 @@ BOOL ina219_get_shunt_voltage (const INA219 *self, int *mv, char **error)
   return ret;
   }
 
+/*============================================================================
+
+  ina219_get_shunt_voltage_uv
+
+  As ina219_get_shunt_voltage, but keeps the full 10uV resolution of the
+  register. With a 100 milliohm shunt, whole millivolts would quantize the
+  current to 10mA steps, which is too coarse for coulomb counting.
+
+============================================================================*/
+BOOL ina219_get_shunt_voltage_uv (const INA219 *self, int *uv, char **error)
+  {
+  BOOL ret = FALSE;
+  int16_t regval;
+  if (ina219_register_read_16 (self, SHUNT_REG, (int16_t*) &regval, error))
+    {
+    *uv = regval * 10;
+    ret = TRUE;
+    }
+
+  return ret;
+  }
+
 /*============================================================================
 
   ina219_create
@@ -199,6 +253,9 @@ BOOL ina219_init (INA219 *self, char **error)
     //   object was created
     if (ioctl (self->fd, I2C_SLAVE, self->i2c_addr) >= 0)
       {
+      unsigned long funcs = 0;
+      self->combined = ioctl (self->fd, I2C_FUNCS, &funcs) >= 0 
+        && (funcs & I2C_FUNC_I2C);
       ret = TRUE;
       }
     else
@@ -221,6 +278,7 @@ void ina219_uninit (INA219 *self)
   assert (self != NULL);
   if (self->fd >= 0) close (self->fd);
   self->fd = -1;
+  self->combined = FALSE;
   }
 
 /*============================================================================
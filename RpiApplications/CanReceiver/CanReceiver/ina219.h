@@ -102,6 +102,11 @@ BOOL     ina219_get_bus_voltage (const INA219 *self, int *mv, char **error);
     value by the resistance between the IN- and IN+ pins. */
 BOOL     ina219_get_shunt_voltage (const INA219 *self, int *mv, char **error);
 
+/** Get the shunt voltage in microvolts, at the full 10uV resolution of
+    the device. Dividing by the shunt resistance in milliohms gives the
+    current in milliamps. */
+BOOL     ina219_get_shunt_voltage_uv (const INA219 *self, int *uv, char **error);
+
 /** Get the overall status in the various arguments. 
     I hope that the meanings of the arguments is self-explanatory. 
     minutes is the time in minutes to full charge or full discharge, 
@@ -1,4 +1,5 @@
 #include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QDebug>
 #include "canreceiver.h"
 
@@ -6,9 +7,42 @@ int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption interfaceOption("interface",
+                                       "CAN interface to read, e.g. vcan0 or can1:probe. Repeat for "
+                                       "several buses; the optional suffix names the signal table.",
+                                       "ifname[:table]", "can0");
+    parser.addOption(interfaceOption);
+    QCommandLineOption recordOption("record",
+                                    "Append every raw CAN frame to flight recorder segments in <dir>.",
+                                    "dir");
+    parser.addOption(recordOption);
+    QCommandLineOption metricsOption("metrics",
+                                     "Periodically write Prometheus text metrics to <file>.",
+                                     "file");
+    parser.addOption(metricsOption);
+    QCommandLineOption batteryRateOption("battery-rate",
+                                         "INA219 sample rate in Hz; 50 enables the fast coulomb-counting mode.",
+                                         "hz", QString::number(1000.0 / BATTERY_SAMPLE_INTERVAL_MS));
+    parser.addOption(batteryRateOption);
+    parser.process(a);
+
     CanReceiver canReceiver;
-    canReceiver.initSocket("can0");
+    if (parser.isSet(recordOption) && !canReceiver.enableRecorder(parser.value(recordOption)))
+        return 1;
+    for (const QString &spec : parser.values(interfaceOption))
+    {
+        QString ifname = spec.section(':', 0, 0);
+        QString table = spec.contains(':') ? spec.section(':', 1) : QString("default");
+        if (!canReceiver.addBus(ifname, table))
+            return 1;
+    }
     canReceiver.initDBusServer("pi.chan", "/can/write");
+    canReceiver.initMetrics(parser.value(metricsOption));
+    double batteryRate = parser.value(batteryRateOption).toDouble();
+    if (batteryRate > 0)
+        canReceiver.setBatteryInterval(qMax(1, int(1000.0 / batteryRate)));
 
     canReceiver.startCommunicate();
 
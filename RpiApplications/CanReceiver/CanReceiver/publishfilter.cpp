@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "publishfilter.h"
+
+PublishFilter::PublishFilter()
+    : deadbands(), heartbeatNs(1000000000), lastSent(), lastSentNs(0), hasSent(false),
+      published(0), suppressed(0), heartbeats(0)
+{
+}
+
+void PublishFilter::setDeadband(int field, int deadband)
+{
+    if (field >= 0 && field < FieldCount)
+        deadbands[field] = deadband < 0 ? 0 : deadband;
+}
+
+void PublishFilter::setHeartbeat(int64_t intervalNs)
+{
+    heartbeatNs = intervalNs;
+}
+
+uint32_t PublishFilter::check(const struct Data &current, int64_t nowNs)
+{
+    uint32_t changed = 0;
+    for (int field = 0; field < FieldCount; field++)
+    {
+        if (abs(current.field(field) - lastSent.field(field)) > deadbands[field])
+            changed |= DATA_FIELD_BIT(field);
+    }
+
+    if (!hasSent)
+        changed = DATA_FIELD_ALL;
+    else if (!changed && heartbeatNs > 0 && nowNs - lastSentNs >= heartbeatNs)
+    {
+        changed = DATA_FIELD_ALL;
+        heartbeats++;
+    }
+
+    if (!changed)
+    {
+        suppressed++;
+        return 0;
+    }
+
+    // Fields inside their deadband keep, here and on the server, the value
+    // last sent, so small drift cannot accumulate unnoticed.
+    for (int field = 0; field < FieldCount; field++)
+    {
+        if (changed & DATA_FIELD_BIT(field))
+            lastSent.field(field) = current.field(field);
+    }
+    lastSent.stamp = current.stamp;
+    lastSentNs = nowNs;
+    hasSent = true;
+    published++;
+    return changed;
+}
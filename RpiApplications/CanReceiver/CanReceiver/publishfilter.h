@@ -0,0 +1,43 @@
+#ifndef PUBLISHFILTER_H
+#define PUBLISHFILTER_H
+
+#include <stdint.h>
+#include "ServerConfig.h"
+
+// Decides whether the publisher needs to send Data to the server. A field
+// counts as changed once it moves further than its deadband from the value
+// last sent; when nothing changed the previous values are re-sent only
+// after the heartbeat interval, so the server can tell the link is alive.
+class PublishFilter
+{
+public:
+    PublishFilter();
+
+    void setDeadband(int field, int deadband);
+    void setHeartbeat(int64_t intervalNs);
+
+    // Returns the DATA_FIELD_BIT mask of changed fields, DATA_FIELD_ALL for
+    // a heartbeat, or 0 if this publish should be suppressed.
+    uint32_t check(const struct Data &current, int64_t nowNs);
+    // What to send after check() returned non-zero: the changed fields of
+    // current, the others as last sent. The server then always holds
+    // exactly the values the deadbands are measured against.
+    const struct Data &sent() const { return lastSent; }
+
+    uint64_t publishedCount() const { return published; }
+    uint64_t suppressedCount() const { return suppressed; }
+    uint64_t heartbeatCount() const { return heartbeats; }
+
+private:
+    int deadbands[FieldCount];
+    int64_t heartbeatNs;
+    struct Data lastSent;
+    int64_t lastSentNs;
+    bool hasSent;
+
+    uint64_t published;
+    uint64_t suppressed;
+    uint64_t heartbeats;
+};
+
+#endif // PUBLISHFILTER_H
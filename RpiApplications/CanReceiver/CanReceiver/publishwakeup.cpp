@@ -0,0 +1,41 @@
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "publishwakeup.h"
+
+PublishWakeup::PublishWakeup()
+    : wakeFD(-1), pending(false)
+{
+}
+
+PublishWakeup::~PublishWakeup()
+{
+    if (wakeFD >= 0)
+        close(wakeFD);
+}
+
+bool PublishWakeup::open()
+{
+    wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return wakeFD >= 0;
+}
+
+void PublishWakeup::notify()
+{
+    if (wakeFD < 0 || pending.exchange(true, std::memory_order_seq_cst))
+        return;
+    const uint64_t one = 1;
+    if (write(wakeFD, &one, sizeof(one)) < 0)
+        pending.store(false, std::memory_order_relaxed);
+}
+
+// Clearing pending before the items are read means an item published
+// meanwhile either is taken now or raises a new wakeup.
+void PublishWakeup::consume()
+{
+    uint64_t count;
+    if (read(wakeFD, &count, sizeof(count)) < 0)
+        count = 0;
+    pending.store(false, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
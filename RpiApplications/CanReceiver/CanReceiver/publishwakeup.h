@@ -0,0 +1,32 @@
+#ifndef PUBLISHWAKEUP_H
+#define PUBLISHWAKEUP_H
+
+#include <atomic>
+
+// Wakes the publisher as soon as a worker has something new for it. The
+// workers (every CAN reader and the battery monitor) share one instance;
+// notify() writes the eventfd only for the first item after the publisher
+// last called consume(), so a burst costs one system call.
+class PublishWakeup
+{
+public:
+    PublishWakeup();
+    PublishWakeup(const PublishWakeup &) = delete;
+    PublishWakeup &operator=(const PublishWakeup &) = delete;
+    ~PublishWakeup();
+
+    bool open();
+    // Readable whenever a notify() has not been consumed yet.
+    int fd() const { return wakeFD; }
+
+    // Any thread, after the new item was made visible.
+    void notify();
+    // Publisher thread, before it takes the items.
+    void consume();
+
+private:
+    int wakeFD;
+    std::atomic<bool> pending;
+};
+
+#endif // PUBLISHWAKEUP_H
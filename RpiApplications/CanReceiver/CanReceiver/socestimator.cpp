@@ -0,0 +1,83 @@
+#include "socestimator.h"
+
+static double clampUnit(double value)
+{
+    return value < 0.0 ? 0.0 : value > 1.0 ? 1.0 : value;
+}
+
+SocEstimator::SocEstimator(int capacityMah, int emptyMv, int fullMv)
+    : capacityMah(capacityMah), emptyMv(emptyMv), fullMv(fullMv)
+{
+    reset();
+}
+
+void SocEstimator::reset()
+{
+    initialized = false;
+    lastNs = 0;
+    state = 0.0;
+    covariance = 1.0;
+    currentAverage = 0.0;
+}
+
+double SocEstimator::voltageSoc(int busMv, double currentMa) const
+{
+    // mA * milliohm = uV
+    double restMv = busMv - currentMa * SOC_INTERNAL_MILLIOHMS / 1000.0;
+    return clampUnit((restMv - emptyMv) / double(fullMv - emptyMv));
+}
+
+void SocEstimator::update(int64_t stampNs, int busMv, double currentMa)
+{
+    double measured = voltageSoc(busMv, currentMa);
+
+    if (!initialized)
+    {
+        // Start from the voltage alone, with its own uncertainty.
+        initialized = true;
+        lastNs = stampNs;
+        state = measured;
+        covariance = SOC_VOLTAGE_NOISE;
+        currentAverage = currentMa;
+        return;
+    }
+
+    double dt = (stampNs - lastNs) / 1e9;
+    lastNs = stampNs;
+    if (dt < 0.0)
+        dt = 0.0;
+
+    // Predict: integrate the charge that flowed since the last sample.
+    if (dt <= SOC_MAX_GAP_S)
+    {
+        state = clampUnit(state + currentMa * (dt / 3600.0) / capacityMah);
+        covariance += SOC_PROCESS_NOISE_PER_S * dt;
+        currentAverage += (currentMa - currentAverage) * (dt / (SOC_CURRENT_TAU_S + dt));
+    }
+    else
+    {
+        covariance = SOC_VOLTAGE_NOISE;
+        currentAverage = currentMa;
+    }
+
+    // Correct with the voltage model, trusted less the harder we pull.
+    double load = 1.0 + (currentMa < 0 ? -currentMa : currentMa) / SOC_VOLTAGE_NOISE_CURRENT_MA;
+    double noise = SOC_VOLTAGE_NOISE * load * load;
+    double gain = covariance / (covariance + noise);
+    state = clampUnit(state + gain * (measured - state));
+    covariance *= 1.0 - gain;
+}
+
+int SocEstimator::percent() const
+{
+    return int(state * 100.0 + 0.5);
+}
+
+int SocEstimator::minutesRemaining(double idleMa) const
+{
+    if (currentAverage > idleMa)
+        return int((1.0 - state) * capacityMah / currentAverage * 60.0);
+    if (currentAverage < -idleMa)
+        return int(state * capacityMah / -currentAverage * 60.0);
+    return 0;
+}
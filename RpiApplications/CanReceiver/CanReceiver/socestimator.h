@@ -0,0 +1,56 @@
+#ifndef SOCESTIMATOR_H
+#define SOCESTIMATOR_H
+
+#include <stdint.h>
+
+// Internal resistance used to undo the voltage sag or rise caused by the
+// load current before the voltage is mapped to a charge level.
+#define SOC_INTERNAL_MILLIOHMS 150
+// Kalman noise: drift of the coulomb counter per second, and the variance
+// of the voltage-derived SoC at rest. The latter grows with the current,
+// since the simple resistance model gets worse under load.
+#define SOC_PROCESS_NOISE_PER_S 1e-7
+#define SOC_VOLTAGE_NOISE 2.5e-3
+#define SOC_VOLTAGE_NOISE_CURRENT_MA 500.0
+// Time constant of the current average used for the time-remaining figure.
+#define SOC_CURRENT_TAU_S 30.0
+// Longer sample gaps are not integrated; the counter would only guess.
+#define SOC_MAX_GAP_S 60.0
+
+// State-of-charge from INA219 readings, O(1) per sample. The state is a
+// one-dimensional Kalman filter: the prediction integrates the shunt
+// current (coulomb counting), and each bus voltage, corrected for the
+// internal resistance and mapped linearly between the empty and full
+// voltages, is the measurement that pulls the counter back.
+// A positive current means the battery is charging, as in the driver.
+class SocEstimator
+{
+public:
+    SocEstimator(int capacityMah, int emptyMv, int fullMv);
+
+    void reset();
+    void update(int64_t stampNs, int busMv, double currentMa);
+
+    bool valid() const { return initialized; }
+    // 0..1
+    double soc() const { return state; }
+    int percent() const;
+    // To full while charging, to empty while discharging, 0 when idle.
+    int minutesRemaining(double idleMa) const;
+    double averageCurrentMa() const { return currentAverage; }
+
+private:
+    double capacityMah;
+    int emptyMv;
+    int fullMv;
+
+    bool initialized;
+    int64_t lastNs;
+    double state;
+    double covariance;
+    double currentAverage;
+
+    double voltageSoc(int busMv, double currentMa) const;
+};
+
+#endif // SOCESTIMATOR_H
@@ -0,0 +1,79 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <stddef.h>
+
+// Fixed-capacity, wait-free single-producer/single-consumer ring. push()
+// may only be called from one thread and pop() from one other thread.
+// Capacity must be a power of two; head and tail are free-running counters,
+// so all Capacity slots are usable.
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    bool push(const T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail >= Capacity)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail >= Capacity)
+                return false;
+        }
+        slots[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == cachedHead)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t == cachedHead)
+                return false;
+        }
+        item = slots[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: the oldest item without removing it, or null when the
+    // ring is empty. Valid until the next pop().
+    const T *front()
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == cachedHead)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t == cachedHead)
+                return nullptr;
+        }
+        return &slots[t & (Capacity - 1)];
+    }
+
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer and consumer indices live on separate cache lines so the two
+    // threads do not false-share.
+    alignas(64) std::atomic<size_t> head;
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail;
+    size_t cachedHead = 0;
+    alignas(64) T slots[Capacity];
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include "telemetrystream.h"
+
+TelemetryStream::TelemetryStream(canid_t canId)
+    : canId(canId), synced(false), nextSequence(0), staleRun(0)
+{
+    resetClock();
+}
+
+void TelemetryStream::resetClock()
+{
+    clockValid = false;
+    lastSenderNs = 0;
+    windowStartNs = 0;
+    currentMin = 0;
+    previousMin = 0;
+}
+
+TelemetryStream::Order TelemetryStream::checkSequence(const CanFrameMeta &meta, uint32_t &lost)
+{
+    uint32_t mask = meta.sequenceBits >= 32 ? ~uint32_t(0) : (uint32_t(1) << meta.sequenceBits) - 1;
+    lost = 0;
+
+    if (!synced)
+    {
+        synced = true;
+        nextSequence = (meta.sequence + 1) & mask;
+        staleRun = 0;
+        return InOrder;
+    }
+
+    uint32_t ahead = (meta.sequence - nextSequence) & mask;
+    if (ahead <= mask / 2)
+    {
+        nextSequence = (meta.sequence + 1) & mask;
+        staleRun = 0;
+        lost = ahead;
+        return ahead ? Gap : InOrder;
+    }
+
+    // Behind the newest frame: late, or the sender started counting over.
+    if (++staleRun < SEQUENCE_RESYNC_FRAMES)
+        return Late;
+    nextSequence = (meta.sequence + 1) & mask;
+    staleRun = 0;
+    resetClock();
+    return InOrder;
+}
+
+// Extends the wrapping sender time to a continuous one, relative to the
+// newest sender time seen.
+int64_t TelemetryStream::unwrap(const CanFrameMeta &meta)
+{
+    int64_t wrap = meta.senderTimeWrapNs;
+    if (wrap <= 0)
+        return meta.senderTimeNs;
+
+    int64_t delta = (meta.senderTimeNs - lastSenderNs) % wrap;
+    if (delta < 0)
+        delta += wrap;
+    if (delta > wrap / 2)
+        delta -= wrap;
+    int64_t senderNs = lastSenderNs + delta;
+    if (delta > 0)
+        lastSenderNs = senderNs;
+    return senderNs;
+}
+
+// The minimum offset is kept for the current and the previous window, so
+// the estimate always covers between one and two windows of frames.
+int64_t TelemetryStream::senderToLocal(const CanFrameMeta &meta, int64_t rxNs)
+{
+    int64_t senderNs = clockValid ? unwrap(meta) : meta.senderTimeNs;
+    int64_t offset = rxNs - senderNs;
+
+    if (clockValid)
+    {
+        int64_t estimate = currentMin < previousMin ? currentMin : previousMin;
+        if (llabs(offset - estimate) > SENDER_CLOCK_RESET_NS)
+        {
+            resetClock();
+            senderNs = meta.senderTimeNs;
+            offset = rxNs - senderNs;
+        }
+    }
+
+    if (!clockValid)
+    {
+        clockValid = true;
+        lastSenderNs = senderNs;
+        windowStartNs = rxNs;
+        currentMin = offset;
+        previousMin = offset;
+    }
+    else if (rxNs - windowStartNs >= SENDER_CLOCK_WINDOW_NS)
+    {
+        previousMin = currentMin;
+        currentMin = offset;
+        windowStartNs = rxNs;
+    }
+    else if (offset < currentMin)
+    {
+        currentMin = offset;
+    }
+
+    return senderNs + (currentMin < previousMin ? currentMin : previousMin);
+}
@@ -0,0 +1,61 @@
+#ifndef TELEMETRYSTREAM_H
+#define TELEMETRYSTREAM_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include "candecoder.h"
+
+// Sender time estimates older than two windows are forgotten, so the
+// offset follows a drifting sender clock.
+# define SENDER_CLOCK_WINDOW_NS 2000000000LL
+// A larger jump means the sender restarted; the estimate starts over.
+# define SENDER_CLOCK_RESET_NS 1000000000LL
+// This many stale frames in a row also mean a restart, not reordering.
+# define SEQUENCE_RESYNC_FRAMES 4
+
+// Receive-side state of one sequenced, sender-stamped CAN stream (one ID
+// on one bus). Only used by the thread reading that bus.
+//
+// Sequence numbers detect lost frames (a forward jump) and late ones
+// (behind the newest seen). Late frames are reported so the caller can
+// drop them instead of overwriting newer values.
+//
+// The sender clock is unrelated to ours, so its stamps are mapped with a
+// min-offset filter: offset = rx time - sender time is smallest for the
+// frame that waited least, and sender time + that minimum is the
+// sender's sampling instant on our clock, short only of the fixed minimum
+// transit time. rx time minus that is the delay each frame picked up in
+// the sender queue, on the bus and in the kernel.
+class TelemetryStream
+{
+public:
+    enum Order { InOrder, Gap, Late };
+
+    TelemetryStream(canid_t canId = 0);
+
+    canid_t id() const { return canId; }
+
+    // Returns the order of this frame and, in lost, how many frames were
+    // skipped before it (Gap only).
+    Order checkSequence(const CanFrameMeta &meta, uint32_t &lost);
+    // The sender time mapped to CLOCK_REALTIME ns, given the frame's RX time.
+    int64_t senderToLocal(const CanFrameMeta &meta, int64_t rxNs);
+
+private:
+    canid_t canId;
+
+    bool synced;
+    uint32_t nextSequence;
+    int staleRun;
+
+    bool clockValid;
+    int64_t lastSenderNs;
+    int64_t windowStartNs;
+    int64_t currentMin;
+    int64_t previousMin;
+
+    void resetClock();
+    int64_t unwrap(const CanFrameMeta &meta);
+};
+
+#endif // TELEMETRYSTREAM_H
@@ -0,0 +1,30 @@
+QT -= gui
+
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+        ../../CanReceiver/CanReceiver/flightrecorder.cpp \
+        caninjector.cpp \
+        framesource.cpp \
+        main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+HEADERS += \
+    ../../CanReceiver/CanReceiver/flightrecorder.h \
+    caninjector.h \
+    framesource.h
+
+INCLUDEPATH += ../../ ../../CanReceiver/CanReceiver/
+
+LIBS += -lpthread
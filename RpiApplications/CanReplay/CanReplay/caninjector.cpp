@@ -0,0 +1,116 @@
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "caninjector.h"
+#include "flightrecorder.h"
+
+#define PACER_SPIN_NS 100000
+
+CanInjector::CanInjector()
+    : socketFD(-1), sent(0), retries(0)
+{
+}
+
+CanInjector::~CanInjector()
+{
+    if (socketFD >= 0)
+        close(socketFD);
+}
+
+bool CanInjector::open(const std::string &ifname)
+{
+    socketFD = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (socketFD < 0)
+        return false;
+
+    // The injector never reads; do not queue our own or foreign traffic.
+    setsockopt(socketFD, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
+    // Needed to write FD frames; classic frames work either way.
+    int fdFrames = 1;
+    setsockopt(socketFD, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &fdFrames, sizeof(fdFrames));
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socketFD, SIOCGIFINDEX, &ifr) < 0)
+        return false;
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    return bind(socketFD, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+}
+
+bool CanInjector::send(const struct canfd_frame &frame)
+{
+    // A classic can_frame is the leading CAN_MTU bytes of a canfd_frame.
+    ssize_t size = (frame.flags & CANFD_FDF) ? CANFD_MTU : CAN_MTU;
+    for (;;)
+    {
+        ssize_t ret = write(socketFD, &frame, size);
+        if (ret == size)
+        {
+            sent++;
+            return true;
+        }
+        if (ret < 0 && (errno == ENOBUFS || errno == EAGAIN || errno == EINTR))
+        {
+            struct pollfd pfd = { socketFD, POLLOUT, 0 };
+            poll(&pfd, 1, 1);
+            retries++;
+            continue;
+        }
+        return false;
+    }
+}
+
+FramePacer::FramePacer()
+    : startNs(0), maxLate(0)
+{
+}
+
+int64_t FramePacer::monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void FramePacer::start()
+{
+    startNs = monotonicNs();
+    maxLate = 0;
+}
+
+int64_t FramePacer::elapsedNs() const
+{
+    return monotonicNs() - startNs;
+}
+
+void FramePacer::waitUntil(int64_t offsetNs)
+{
+    int64_t deadline = startNs + offsetNs;
+    int64_t now = monotonicNs();
+
+    if (deadline - now > PACER_SPIN_NS)
+    {
+        int64_t wake = deadline - PACER_SPIN_NS;
+        struct timespec ts;
+        ts.tv_sec = wake / 1000000000;
+        ts.tv_nsec = wake % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+    }
+    while ((now = monotonicNs()) < deadline)
+        ;
+
+    if (now - deadline > maxLate)
+        maxLate = now - deadline;
+}
@@ -0,0 +1,48 @@
+#ifndef CANINJECTOR_H
+#define CANINJECTOR_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include <string>
+
+// Raw CAN socket for writing frames, normally to a vcan interface. Frames
+// with CANFD_FDF in their flags go out as CAN FD, the rest as classic CAN.
+class CanInjector
+{
+public:
+    CanInjector();
+    ~CanInjector();
+
+    bool open(const std::string &ifname);
+    // Retries while the interface TX queue is full (ENOBUFS).
+    bool send(const struct canfd_frame &frame);
+
+    uint64_t sentCount() const { return sent; }
+    uint64_t retryCount() const { return retries; }
+
+private:
+    int socketFD;
+    uint64_t sent;
+    uint64_t retries;
+};
+
+// Absolute-deadline pacing on CLOCK_MONOTONIC. Sleeps until shortly before
+// the deadline and spins the rest, so sub-millisecond gaps stay accurate.
+class FramePacer
+{
+public:
+    FramePacer();
+
+    void start();
+    void waitUntil(int64_t offsetNs);
+    int64_t elapsedNs() const;
+    int64_t maxLateNs() const { return maxLate; }
+
+    static int64_t monotonicNs();
+
+private:
+    int64_t startNs;
+    int64_t maxLate;
+};
+
+#endif // CANINJECTOR_H
@@ -0,0 +1,107 @@
+#include <math.h>
+#include <string.h>
+#include "framesource.h"
+
+#define PROFILE_CAN_ID 0x43
+#define PROFILE_MAX_RPM 5000
+
+LogFrameSource::LogFrameSource()
+    : startNs(0)
+{
+}
+
+bool LogFrameSource::open(const std::string &dir, int64_t skipNs)
+{
+    if (!reader.open(dir))
+        return false;
+    startNs = reader.firstStamp() + skipNs;
+    return reader.seek(startNs);
+}
+
+bool LogFrameSource::next(struct canfd_frame &frame, int64_t &offsetNs)
+{
+    FlightRecord record;
+    if (!reader.next(record))
+        return false;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = record.canId;
+    frame.flags = record.flags;
+    uint8_t maxLen = (record.flags & CANFD_FDF) ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    frame.len = record.len > maxLen ? maxLen : record.len;
+    memcpy(frame.data, record.data, frame.len);
+    offsetNs = record.stampNs - startNs;
+    return true;
+}
+
+bool LogFrameSource::rewind()
+{
+    return reader.seek(startNs);
+}
+
+ProfileFrameSource::ProfileFrameSource(Profile profile, double rateHz, uint64_t frameCount)
+    : profile(profile), periodNs(1e9 / rateHz), frameCount(frameCount), index(0),
+      randomState(0x2545f491)
+{
+}
+
+bool ProfileFrameSource::parseProfile(const std::string &name, Profile &profile)
+{
+    if (name == "constant")
+        profile = Constant;
+    else if (name == "ramp")
+        profile = Ramp;
+    else if (name == "sine")
+        profile = Sine;
+    else if (name == "random")
+        profile = Random;
+    else
+        return false;
+    return true;
+}
+
+bool ProfileFrameSource::next(struct canfd_frame &frame, int64_t &offsetNs)
+{
+    if (frameCount && index >= frameCount)
+        return false;
+
+    offsetNs = int64_t(index * periodNs);
+    double t = offsetNs / 1e9;
+
+    int rpm;
+    switch (profile)
+    {
+    case Ramp:
+        rpm = int(fmod(t, 10.0) / 10.0 * PROFILE_MAX_RPM);
+        break;
+    case Sine:
+        rpm = int((1.0 + sin(2 * M_PI * 0.2 * t)) * PROFILE_MAX_RPM / 2);
+        break;
+    case Random:
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        rpm = int(randomState % PROFILE_MAX_RPM);
+        break;
+    default:
+        rpm = PROFILE_MAX_RPM / 2;
+        break;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = PROFILE_CAN_ID;
+    frame.len = CAN_MAX_DLEN;
+    frame.data[0] = uint8_t(rpm >> 8);
+    frame.data[1] = uint8_t(rpm & 0xff);
+    frame.data[2] = uint8_t(25 + 5 * sin(2 * M_PI * 0.01 * t));
+    frame.data[3] = uint8_t(50 + 10 * sin(2 * M_PI * 0.005 * t));
+
+    index++;
+    return true;
+}
+
+bool ProfileFrameSource::rewind()
+{
+    index = 0;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include <string>
+#include "flightrecorder.h"
+
+// Produces frames together with their send time, in ns relative to the
+// first frame of the run.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() {}
+
+    virtual bool next(struct canfd_frame &frame, int64_t &offsetNs) = 0;
+    virtual bool rewind() = 0;
+};
+
+// Replays a flight recorder directory, optionally starting skipNs after the
+// first recorded frame.
+class LogFrameSource : public FrameSource
+{
+public:
+    LogFrameSource();
+
+    bool open(const std::string &dir, int64_t skipNs);
+    uint64_t recordCount() const { return reader.recordCount(); }
+
+    bool next(struct canfd_frame &frame, int64_t &offsetNs) override;
+    bool rewind() override;
+
+private:
+    FlightReader reader;
+    int64_t startNs;
+};
+
+// Synthetic speed frames (SPEED_FRAME_ID layout: rpm in bytes 0-1
+// big-endian, temperature in byte 2, humidity in byte 3) at a fixed rate.
+class ProfileFrameSource : public FrameSource
+{
+public:
+    enum Profile { Constant, Ramp, Sine, Random };
+
+    ProfileFrameSource(Profile profile, double rateHz, uint64_t frameCount);
+
+    static bool parseProfile(const std::string &name, Profile &profile);
+
+    bool next(struct canfd_frame &frame, int64_t &offsetNs) override;
+    bool rewind() override;
+
+private:
+    Profile profile;
+    double periodNs;
+    uint64_t frameCount;
+    uint64_t index;
+    uint32_t randomState;
+};
+
+#endif // FRAMESOURCE_H
@@ -0,0 +1,108 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <memory>
+#include "caninjector.h"
+#include "framesource.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("CanReplay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a CanReceiver flight recording or a synthetic "
+                                     "profile into a (v)can interface.");
+    parser.addHelpOption();
+    QCommandLineOption interfaceOption("interface", "CAN interface to write to.", "ifname", "vcan0");
+    QCommandLineOption logOption("log", "Flight recorder directory to replay.", "dir");
+    QCommandLineOption skipOption("skip", "Seconds to skip from the start of the log.", "seconds", "0");
+    QCommandLineOption profileOption("profile", "Synthetic profile: constant, ramp, sine or random.",
+                                     "name", "sine");
+    QCommandLineOption rateOption("rate", "Synthetic frame rate in Hz.", "hz", "100");
+    QCommandLineOption countOption("count", "Synthetic frames to send, 0 for unlimited.", "n", "0");
+    QCommandLineOption speedOption("speed", "Time scale: 1 is real time, N is N times faster.", "n", "1");
+    QCommandLineOption maxOption("max", "Send as fast as the interface accepts, ignoring timing.");
+    QCommandLineOption loopOption("loop", "Start over when the source is exhausted.");
+    parser.addOptions({ interfaceOption, logOption, skipOption, profileOption, rateOption,
+                        countOption, speedOption, maxOption, loopOption });
+    parser.process(a);
+
+    std::unique_ptr<FrameSource> source;
+    if (parser.isSet(logOption))
+    {
+        LogFrameSource *log = new LogFrameSource();
+        source.reset(log);
+        int64_t skipNs = int64_t(parser.value(skipOption).toDouble() * 1e9);
+        if (!log->open(parser.value(logOption).toStdString(), skipNs))
+        {
+            qDebug() << "Failed to open flight recording" << parser.value(logOption);
+            return 1;
+        }
+        qDebug() << "Replaying" << log->recordCount() << "recorded frames";
+    }
+    else
+    {
+        ProfileFrameSource::Profile profile;
+        if (!ProfileFrameSource::parseProfile(parser.value(profileOption).toStdString(), profile))
+        {
+            qDebug() << "Unknown profile" << parser.value(profileOption);
+            return 1;
+        }
+        double rate = parser.value(rateOption).toDouble();
+        if (rate <= 0)
+        {
+            qDebug() << "Rate must be positive";
+            return 1;
+        }
+        source.reset(new ProfileFrameSource(profile, rate, parser.value(countOption).toULongLong()));
+    }
+
+    double speed = parser.value(speedOption).toDouble();
+    if (speed <= 0)
+    {
+        qDebug() << "Speed must be positive";
+        return 1;
+    }
+    bool maxRate = parser.isSet(maxOption);
+
+    CanInjector injector;
+    if (!injector.open(parser.value(interfaceOption).toStdString()))
+    {
+        qDebug() << "Failed to open CAN interface" << parser.value(interfaceOption);
+        return 1;
+    }
+
+    FramePacer pacer;
+    pacer.start();
+    int64_t loopBaseNs = 0;
+    int64_t lastOffsetNs = 0;
+    struct canfd_frame frame;
+    int64_t offsetNs;
+
+    for (;;)
+    {
+        if (!source->next(frame, offsetNs))
+        {
+            if (!parser.isSet(loopOption) || !source->rewind())
+                break;
+            loopBaseNs += lastOffsetNs;
+            continue;
+        }
+        lastOffsetNs = offsetNs;
+
+        if (!maxRate)
+            pacer.waitUntil(int64_t((loopBaseNs + offsetNs) / speed));
+        if (!injector.send(frame))
+        {
+            qDebug() << "Failed to send CAN frame";
+            return 1;
+        }
+    }
+
+    double seconds = pacer.elapsedNs() / 1e9;
+    qDebug() << "Sent" << injector.sentCount() << "frames in" << seconds << "s ("
+             << (seconds > 0 ? injector.sentCount() / seconds : 0) << "frames/s ), TX retries"
+             << injector.retryCount() << ", max lateness" << pacer.maxLateNs() / 1000 << "us";
+    return 0;
+}
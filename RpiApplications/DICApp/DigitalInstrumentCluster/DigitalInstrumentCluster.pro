@@ -1,18 +1,27 @@
-QT += dbus quick
+QT += concurrent dbus quick
+
+# Compile QML ahead of time so startup skips parsing and JIT.
+CONFIG += qtquickcompiler
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        ../../datamanagerlink.cpp \
+        ../../telemetryshm.cpp \
+        frametimer.cpp \
+        gaugeitem.cpp \
         main.cpp \
-        qmlcontroller.cpp
+        qmlcontroller.cpp \
+        shmsubscriber.cpp
 
 RESOURCES += qml.qrc \
     components/components.qrc \
     images/images.qrc
 
 DBUS_INTERFACES += ../../interfaces/datamanager.xml
+QDBUSXML2CPP_INTERFACE_HEADER_FLAGS += -i ServerConfig.h
 
 # Additional import path used to resolve QML modules in Qt Creator's code model
 QML_IMPORT_PATH =
@@ -20,6 +29,12 @@ QML_IMPORT_PATH =
 # Additional import path used to resolve QML modules just for Qt Quick Designer
 QML_DESIGNER_IMPORT_PATH =
 
+# qmake CONFIG+=alloc_tracking counts heap allocations per pipeline stage.
+alloc_tracking {
+    DEFINES += PI_ALLOC_TRACKING
+    SOURCES += ../../alloctracker.cpp
+}
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -27,7 +42,17 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     ../../ServerConfig.h \
-    qmlcontroller.h
+    ../../alloctracker.h \
+    ../../datamanagerlink.h \
+    ../../latencyhistogram.h \
+    ../../seqlock.h \
+    ../../telemetryshm.h \
+    frametimer.h \
+    gaugeitem.h \
+    qmlcontroller.h \
+    shmsubscriber.h
 
 
 INCLUDEPATH += ../../
+
+LIBS += -lrt
@@ -20,8 +20,11 @@ Item {
             }
             width: parent.width
             height: parent.height
-            opacity: 0.3
-            source: "qrc:/back.png"
+            // Pre-scaled to the 1024x600 panel with the 30 % tint over
+            // #171717 baked in, so it decodes small and draws opaque.
+            source: "qrc:/back_1024x600.png"
+            sourceSize: Qt.size(1024, 600)
+            asynchronous: true
             z: 1
         }
 
@@ -1,13 +1,16 @@
 import QtQuick 2.15
+import QtQuick.Window 2.15
 import QtQuick.Controls 2.15
 import qml.data 1.0
 
 Item {
+    id: container
     width: parent ? parent.width : 1024
     height: parent ? parent.height : 600
 
     DataController {
         id: datacontroller
+        window: container.Window.window
     }
 
     Rectangle {
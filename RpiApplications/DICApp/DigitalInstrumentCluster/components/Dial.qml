@@ -0,0 +1,30 @@
+import QtQuick 2.15
+import qml.gauge 1.0
+
+// NativeGauge with its value labels. The labels are plain Text items that
+// only move when the scale changes, never when the value does.
+NativeGauge {
+    id: gauge
+
+    property real labelStepSize: tickmarkStepSize
+    property color labelColor: tickColor
+
+    Repeater {
+        model: gauge.labelStepSize > 0 && gauge.maximumValue > gauge.minimumValue
+               ? Math.floor((gauge.maximumValue - gauge.minimumValue) / gauge.labelStepSize) + 1 : 0
+
+        Text {
+            readonly property real labelValue: gauge.minimumValue + index * gauge.labelStepSize
+            readonly property real angle: gauge.valueToAngle(labelValue) * Math.PI / 180
+            readonly property real distance: gauge.outerRadius * 0.75
+
+            x: gauge.width / 2 + Math.sin(angle) * distance - width / 2
+            y: gauge.height / 2 - Math.cos(angle) * distance - height / 2
+            text: labelValue
+            font.pixelSize: Math.max(3, gauge.outerRadius * 0.1)
+            color: gauge.warningValue >= gauge.minimumValue && labelValue >= gauge.warningValue
+                   ? gauge.warningColor : gauge.labelColor
+            antialiasing: true
+        }
+    }
+}
@@ -1,6 +1,5 @@
 import QtQuick 2.15
-import QtQuick.Extras 1.4
-import QtQuick.Controls.Styles 1.4
+import QtQuick.Window 2.15
 import qml.data 1.0
 import QtGraphicalEffects 1.0
 
@@ -12,9 +11,10 @@ Item {
 
     DataController {
         id: datacontroller
+        window: container.Window.window
     }
 
-    CircularGauge {
+    Dial {
         id: rpmGauge
         width: height
         height: parent.height * 0.5
@@ -25,10 +25,10 @@ Item {
         value: datacontroller.rpm // 스피드 값 넣기
         minimumValue: 0
         maximumValue: 5000 // 최대값
-
-        style: GaugeStyles {
-
-        }
+        minimumValueAngle: -130
+        maximumValueAngle: 110
+        tickmarkStepSize: 500
+        warningValue: maximumValue * 0.8
 
         Behavior on value {
             NumberAnimation {
@@ -37,7 +37,7 @@ Item {
         }
     }
 
-    CircularGauge {
+    Dial {
         id: speedGauge
         width: height
         height: parent.height * 0.5
@@ -47,6 +47,7 @@ Item {
         value: datacontroller.rpm
         minimumValue: 0
         maximumValue: 300
+        labelStepSize: 30
 
         Behavior on value {
             NumberAnimation {
@@ -83,7 +84,8 @@ Item {
             id: batteryImg
             width: parent.width
             height: parent.height
-            source: "qrc:/battery.png"
+            source: "qrc:/battery_128.png"
+            sourceSize: Qt.size(128, 128)
         }
 
         ColorOverlay {
@@ -93,12 +95,12 @@ Item {
             }
     }
 
-    Gauge {
+    LevelBar {
         id: temperature
         minimumValue: 0
         maximumValue: 50
         value: datacontroller.temperature
-        width: parent.width
+        width: parent.width * 0.05
         height: parent.height * 0.2
         x: ((parent.x + parent.width) / 2) - parent.width * 0.1
         anchors {
@@ -106,12 +108,7 @@ Item {
             bottomMargin: parent.height * 0.05
         }
 
-        style: GaugeStyle {
-            valueBar: Rectangle {
-                implicitWidth: 8
-                color: "#FF0000"
-            }
-        }
+        color: "#FF0000"
 
         Behavior on value {
             NumberAnimation {
@@ -120,12 +117,12 @@ Item {
         }
     }
 
-    Gauge {
+    LevelBar {
         id: humidity
         minimumValue: 0
         maximumValue: 100
         value: datacontroller.humidity
-        width: parent.width
+        width: parent.width * 0.05
         height: parent.height * 0.2
         x: ((parent.x + parent.width) / 2)
         anchors {
@@ -133,12 +130,7 @@ Item {
             bottomMargin: parent.height * 0.05
         }
 
-        style: GaugeStyle {
-            valueBar: Rectangle {
-                implicitWidth: 8
-                color: "#0000FF"
-            }
-        }
+        color: "#0000FF"
 
         Behavior on value {
             NumberAnimation {
@@ -0,0 +1,56 @@
+import QtQuick 2.15
+
+// Vertical bar filled from the bottom, labels on its left. Plain
+// Rectangles and Texts: only the fill's height follows the value.
+Item {
+    id: bar
+
+    property real minimumValue: 0
+    property real maximumValue: 100
+    property real value: 0
+    property real labelStepSize: (maximumValue - minimumValue) / 5
+    property color color: "#FFFFFF"
+    property color trackColor: "#40FFFFFF"
+    property color labelColor: "#C0C0C0"
+
+    readonly property real fraction: maximumValue > minimumValue
+                                     ? Math.max(0, Math.min(1, (value - minimumValue) / (maximumValue - minimumValue)))
+                                     : 0
+
+    implicitWidth: 40
+    implicitHeight: 120
+
+    Rectangle {
+        id: track
+        width: 8
+        color: bar.trackColor
+        anchors {
+            right: parent.right
+            top: parent.top
+            bottom: parent.bottom
+        }
+
+        Rectangle {
+            width: parent.width
+            height: parent.height * bar.fraction
+            anchors.bottom: parent.bottom
+            color: bar.color
+        }
+    }
+
+    Repeater {
+        model: bar.labelStepSize > 0 && bar.maximumValue > bar.minimumValue
+               ? Math.floor((bar.maximumValue - bar.minimumValue) / bar.labelStepSize) + 1 : 0
+
+        Text {
+            readonly property real labelValue: bar.minimumValue + index * bar.labelStepSize
+
+            anchors.right: track.left
+            anchors.rightMargin: 4
+            y: track.height * (bar.maximumValue - labelValue) / (bar.maximumValue - bar.minimumValue) - height / 2
+            text: labelValue
+            font.pixelSize: Math.max(6, bar.height * 0.1)
+            color: bar.labelColor
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include <QDebug>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <QTimer>
+#include <time.h>
+#include "frametimer.h"
+
+static int64_t monotonicNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+FrameTimer::FrameTimer(QQuickWindow *window, int reportIntervalMs, QObject *parent)
+    : QObject{parent}, window(window), lastSwapNs(0), renderStartNs(0)
+{
+    // Direct connections: these run on the render thread, between frames.
+    connect(window, &QQuickWindow::beforeRendering, this, [this]() {
+        renderStartNs.store(monotonicNs(), std::memory_order_relaxed);
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, [this]() {
+        renderTime.record(monotonicNs() - renderStartNs.load(std::memory_order_relaxed));
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        int64_t now = monotonicNs();
+        int64_t last = lastSwapNs.exchange(now, std::memory_order_relaxed);
+        if (last)
+            frameInterval.record(now - last);
+    }, Qt::DirectConnection);
+
+    QTimer *timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(report()));
+    timer->start(reportIntervalMs);
+}
+
+void FrameTimer::report()
+{
+    if (!frameInterval.count())
+        return;
+    bool software = window->rendererInterface()->graphicsApi() == QSGRendererInterface::Software;
+    qDebug().noquote() << QString("Frames %1 (%2) | interval p50 %3 ms p99 %4 ms max %5 ms | "
+                                  "render p50 %6 ms p99 %7 ms")
+                          .arg(frameInterval.count()).arg(software ? "software" : "hardware")
+                          .arg(frameInterval.percentileNs(0.5) / 1e6, 0, 'f', 2)
+                          .arg(frameInterval.percentileNs(0.99) / 1e6, 0, 'f', 2)
+                          .arg(frameInterval.maxNs() / 1e6, 0, 'f', 2)
+                          .arg(renderTime.percentileNs(0.5) / 1e6, 0, 'f', 2)
+                          .arg(renderTime.percentileNs(0.99) / 1e6, 0, 'f', 2);
+    frameInterval.reset();
+    renderTime.reset();
+}
@@ -0,0 +1,32 @@
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
+
+#include <QObject>
+#include <atomic>
+#include "latencyhistogram.h"
+
+class QQuickWindow;
+
+// Frame statistics for a QQuickWindow, with any scene graph backend:
+// the interval between swaps and the time spent rendering each frame.
+// The window signals fire on the render thread and only record into
+// atomic histograms; the GUI thread prints a summary periodically.
+class FrameTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrameTimer(QQuickWindow *window, int reportIntervalMs, QObject *parent = nullptr);
+
+private slots:
+    void report();
+
+private:
+    QQuickWindow *window;
+    LatencyHistogram frameInterval;
+    LatencyHistogram renderTime;
+    std::atomic<int64_t> lastSwapNs;
+    std::atomic<int64_t> renderStartNs;
+};
+
+#endif // FRAMETIMER_H
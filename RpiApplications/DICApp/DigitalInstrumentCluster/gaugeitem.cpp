@@ -0,0 +1,406 @@
+#include <QImage>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGRectangleNode>
+#include <QSGRendererInterface>
+#include <QSGVertexColorMaterial>
+#include <QtMath>
+#include "alloctracker.h"
+#include "gaugeitem.h"
+
+// Proportions relative to the outer radius, matching the old GaugeStyles.
+#define GAUGE_TICK_OUTER 0.96
+#define GAUGE_MAJOR_LENGTH 0.07
+#define GAUGE_MAJOR_WIDTH 0.02
+#define GAUGE_MINOR_LENGTH 0.03
+#define GAUGE_MINOR_WIDTH 0.01
+#define GAUGE_ARC_WIDTH 0.02
+#define GAUGE_ARC_STEP_DEGREES 2.0
+#define GAUGE_HUB_RADIUS 0.075
+#define GAUGE_HUB_SEGMENTS 32
+#define GAUGE_NEEDLE_LENGTH 0.8
+#define GAUGE_NEEDLE_TAIL 0.12
+#define GAUGE_NEEDLE_WIDTH 0.05
+
+namespace {
+
+// Root of the gauge subtree; keeps the one node a value change touches.
+struct GaugeNode : public QSGNode
+{
+    QSGTransformNode *needle = nullptr;
+};
+
+int triangleVertexCount(const QPolygonF &polygon)
+{
+    return polygon.size() < 3 ? 0 : (polygon.size() - 2) * 3;
+}
+
+QSGGeometryNode *flatPolygonNode(const QPolygonF &polygon, const QColor &color)
+{
+    QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(),
+                                            triangleVertexCount(polygon));
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+    QSGGeometry::Point2D *vertex = geometry->vertexDataAsPoint2D();
+    for (int i = 1; i + 1 < polygon.size(); i++)
+    {
+        (vertex++)->set(polygon[0].x(), polygon[0].y());
+        (vertex++)->set(polygon[i].x(), polygon[i].y());
+        (vertex++)->set(polygon[i + 1].x(), polygon[i + 1].y());
+    }
+
+    QSGFlatColorMaterial *material = new QSGFlatColorMaterial;
+    material->setColor(color);
+
+    QSGGeometryNode *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setMaterial(material);
+    node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    return node;
+}
+
+QImage renderPolygons(const QSizeF &size, qreal devicePixelRatio,
+                      const QVector<QPair<QPolygonF, QColor>> &polygons)
+{
+    QImage image((size * devicePixelRatio).toSize(), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    for (const QPair<QPolygonF, QColor> &polygon : polygons)
+    {
+        painter.setBrush(polygon.second);
+        painter.drawPolygon(polygon.first);
+    }
+    return image;
+}
+
+}
+
+GaugeItem::GaugeItem(QQuickItem *parent)
+    : QQuickItem{parent}, currentValue(0), minimum(0), maximum(100),
+      minimumAngle(-145), maximumAngle(145), tickStep(10), minorCount(4),
+      warning(-1), majorColor("#e5e5e5"), minorColor("#61D3F7"),
+      alertColor("#9C0412"), pointerColor("#e5e5e5"), scaleDirty(true)
+{
+    setFlag(ItemHasContents);
+}
+
+void GaugeItem::setValue(qreal newValue)
+{
+    if (currentValue == newValue)
+        return;
+    currentValue = newValue;
+    emit valueChanged();
+    update();
+}
+
+void GaugeItem::invalidateScale()
+{
+    scaleDirty = true;
+    emit dialChanged();
+    update();
+}
+
+void GaugeItem::setMinimumValue(qreal newMinimum)
+{
+    if (minimum == newMinimum)
+        return;
+    minimum = newMinimum;
+    invalidateScale();
+}
+
+void GaugeItem::setMaximumValue(qreal newMaximum)
+{
+    if (maximum == newMaximum)
+        return;
+    maximum = newMaximum;
+    invalidateScale();
+}
+
+void GaugeItem::setMinimumValueAngle(qreal angle)
+{
+    if (minimumAngle == angle)
+        return;
+    minimumAngle = angle;
+    invalidateScale();
+}
+
+void GaugeItem::setMaximumValueAngle(qreal angle)
+{
+    if (maximumAngle == angle)
+        return;
+    maximumAngle = angle;
+    invalidateScale();
+}
+
+void GaugeItem::setTickmarkStepSize(qreal step)
+{
+    if (tickStep == step || step <= 0)
+        return;
+    tickStep = step;
+    invalidateScale();
+}
+
+void GaugeItem::setMinorTickmarkCount(int count)
+{
+    if (minorCount == count || count < 0)
+        return;
+    minorCount = count;
+    invalidateScale();
+}
+
+void GaugeItem::setWarningValue(qreal newWarning)
+{
+    if (warning == newWarning)
+        return;
+    warning = newWarning;
+    invalidateScale();
+}
+
+void GaugeItem::setTickColor(const QColor &color)
+{
+    if (majorColor == color)
+        return;
+    majorColor = color;
+    invalidateScale();
+}
+
+void GaugeItem::setMinorTickColor(const QColor &color)
+{
+    if (minorColor == color)
+        return;
+    minorColor = color;
+    invalidateScale();
+}
+
+void GaugeItem::setWarningColor(const QColor &color)
+{
+    if (alertColor == color)
+        return;
+    alertColor = color;
+    invalidateScale();
+}
+
+void GaugeItem::setNeedleColor(const QColor &color)
+{
+    if (pointerColor == color)
+        return;
+    pointerColor = color;
+    invalidateScale();
+}
+
+qreal GaugeItem::valueToAngle(qreal value) const
+{
+    if (maximum <= minimum)
+        return minimumAngle;
+    qreal fraction = (qBound(minimum, value, maximum) - minimum) / (maximum - minimum);
+    return minimumAngle + fraction * (maximumAngle - minimumAngle);
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+void GaugeItem::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+#else
+void GaugeItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+#endif
+    if (newGeometry.size() != oldGeometry.size())
+        invalidateScale();
+}
+
+// Ticks and the warning arc, as convex polygons in item coordinates.
+QVector<GaugeItem::Shape> GaugeItem::faceShapes() const
+{
+    QVector<Shape> shapes;
+    const qreal radius = outerRadius();
+    const QPointF center(width() / 2, height() / 2);
+    const bool warningOn = warning >= minimum;
+
+    auto point = [&](qreal angle, qreal distance) {
+        qreal rad = qDegreesToRadians(angle);
+        return center + QPointF(qSin(rad), -qCos(rad)) * distance;
+    };
+    auto tick = [&](qreal value, qreal length, qreal thickness, const QColor &color) {
+        qreal angle = valueToAngle(value);
+        qreal rad = qDegreesToRadians(angle);
+        QPointF side = QPointF(qCos(rad), qSin(rad)) * (thickness / 2);
+        QPointF outer = point(angle, radius * GAUGE_TICK_OUTER);
+        QPointF inner = point(angle, radius * GAUGE_TICK_OUTER - length);
+        shapes.append({ QPolygonF({ outer - side, outer + side, inner + side, inner - side }), color });
+    };
+
+    if (maximum > minimum)
+    {
+        const qreal epsilon = tickStep * 1e-6;
+        for (qreal major = minimum; major <= maximum + epsilon; major += tickStep)
+        {
+            bool alert = warningOn && major >= warning;
+            tick(major, radius * GAUGE_MAJOR_LENGTH, radius * GAUGE_MAJOR_WIDTH,
+                 alert ? alertColor : majorColor);
+
+            for (int i = 1; i <= minorCount; i++)
+            {
+                qreal minor = major + tickStep * i / (minorCount + 1);
+                if (minor > maximum || (warningOn && minor >= warning))
+                    break;
+                tick(minor, radius * GAUGE_MINOR_LENGTH, radius * GAUGE_MINOR_WIDTH, minorColor);
+            }
+        }
+    }
+
+    if (warningOn && warning < maximum)
+    {
+        qreal from = valueToAngle(warning);
+        qreal to = valueToAngle(maximum);
+        int segments = qMax(1, qCeil(qAbs(to - from) / GAUGE_ARC_STEP_DEGREES));
+        qreal inner = radius * (1 - GAUGE_ARC_WIDTH);
+        for (int i = 0; i < segments; i++)
+        {
+            qreal a0 = from + (to - from) * i / segments;
+            qreal a1 = from + (to - from) * (i + 1) / segments;
+            shapes.append({ QPolygonF({ point(a0, radius), point(a1, radius),
+                                        point(a1, inner), point(a0, inner) }), alertColor });
+        }
+    }
+    return shapes;
+}
+
+QPolygonF GaugeItem::hubPolygon() const
+{
+    QPolygonF hub;
+    qreal hubRadius = outerRadius() * GAUGE_HUB_RADIUS;
+    QPointF center(width() / 2, height() / 2);
+    for (int i = 0; i < GAUGE_HUB_SEGMENTS; i++)
+    {
+        qreal rad = 2 * M_PI * i / GAUGE_HUB_SEGMENTS;
+        hub << center + QPointF(qCos(rad), qSin(rad)) * hubRadius;
+    }
+    return hub;
+}
+
+// Pointing straight up from the pivot at the origin; needleMatrix() moves
+// it to the center and turns it.
+QPolygonF GaugeItem::needlePolygon() const
+{
+    qreal radius = outerRadius();
+    qreal half = radius * GAUGE_NEEDLE_WIDTH / 2;
+    return QPolygonF({ QPointF(0, -radius * GAUGE_NEEDLE_LENGTH), QPointF(half, 0),
+                       QPointF(0, radius * GAUGE_NEEDLE_TAIL), QPointF(-half, 0) });
+}
+
+QMatrix4x4 GaugeItem::needleMatrix() const
+{
+    QMatrix4x4 matrix;
+    matrix.translate(width() / 2, height() / 2);
+    // With y pointing down, a positive turn about z is clockwise.
+    matrix.rotate(valueToAngle(currentValue), 0, 0, 1);
+    return matrix;
+}
+
+QSGNode *GaugeItem::buildHardwareNodes() const
+{
+    GaugeNode *root = new GaugeNode;
+
+    // Every tick and arc segment in one vertex-colored draw call.
+    QVector<Shape> shapes = faceShapes();
+    int vertexCount = 0;
+    for (const Shape &shape : shapes)
+        vertexCount += triangleVertexCount(shape.polygon);
+
+    QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), vertexCount);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+    QSGGeometry::ColoredPoint2D *vertex = geometry->vertexDataAsColoredPoint2D();
+    for (const Shape &shape : shapes)
+    {
+        // The vertex color material expects premultiplied colors.
+        uchar a = uchar(shape.color.alpha());
+        uchar r = uchar(shape.color.red() * a / 255);
+        uchar g = uchar(shape.color.green() * a / 255);
+        uchar b = uchar(shape.color.blue() * a / 255);
+        const QPolygonF &polygon = shape.polygon;
+        for (int i = 1; i + 1 < polygon.size(); i++)
+        {
+            (vertex++)->set(polygon[0].x(), polygon[0].y(), r, g, b, a);
+            (vertex++)->set(polygon[i].x(), polygon[i].y(), r, g, b, a);
+            (vertex++)->set(polygon[i + 1].x(), polygon[i + 1].y(), r, g, b, a);
+        }
+    }
+
+    QSGGeometryNode *face = new QSGGeometryNode;
+    face->setGeometry(geometry);
+    face->setMaterial(new QSGVertexColorMaterial);
+    face->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    root->appendChildNode(face);
+
+    root->needle = new QSGTransformNode;
+    root->needle->appendChildNode(flatPolygonNode(needlePolygon(), pointerColor));
+    root->appendChildNode(root->needle);
+
+    root->appendChildNode(flatPolygonNode(hubPolygon(), majorColor));
+    return root;
+}
+
+QSGNode *GaugeItem::buildSoftwareNodes() const
+{
+    GaugeNode *root = new GaugeNode;
+    QQuickWindow *quickWindow = window();
+    qreal ratio = quickWindow->effectiveDevicePixelRatio();
+
+    QVector<QPair<QPolygonF, QColor>> face;
+    for (const Shape &shape : faceShapes())
+        face.append(qMakePair(shape.polygon, shape.color));
+    QSGImageNode *faceNode = quickWindow->createImageNode();
+    faceNode->setTexture(quickWindow->createTextureFromImage(renderPolygons(size(), ratio, face)));
+    faceNode->setOwnsTexture(true);
+    faceNode->setRect(boundingRect());
+    root->appendChildNode(faceNode);
+
+    qreal radius = outerRadius();
+    qreal half = radius * GAUGE_NEEDLE_WIDTH / 4;
+    QSGRectangleNode *needle = quickWindow->createRectangleNode();
+    needle->setRect(QRectF(QPointF(-half, -radius * GAUGE_NEEDLE_LENGTH),
+                           QPointF(half, radius * GAUGE_NEEDLE_TAIL)));
+    needle->setColor(pointerColor);
+    root->needle = new QSGTransformNode;
+    root->needle->appendChildNode(needle);
+    root->appendChildNode(root->needle);
+
+    QVector<QPair<QPolygonF, QColor>> hub;
+    hub.append(qMakePair(hubPolygon(), majorColor));
+    QSGImageNode *hubNode = quickWindow->createImageNode();
+    hubNode->setTexture(quickWindow->createTextureFromImage(renderPolygons(size(), ratio, hub)));
+    hubNode->setOwnsTexture(true);
+    hubNode->setRect(boundingRect());
+    root->appendChildNode(hubNode);
+    return root;
+}
+
+QSGNode *GaugeItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    ALLOC_STAGE(AllocStageDicRender);
+    GaugeNode *node = static_cast<GaugeNode *>(oldNode);
+    if (width() <= 0 || height() <= 0)
+    {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node || scaleDirty)
+    {
+        delete node;
+        bool software = window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software;
+        node = static_cast<GaugeNode *>(software ? buildSoftwareNodes() : buildHardwareNodes());
+        scaleDirty = false;
+    }
+
+    // The only per-value work: one matrix.
+    node->needle->setMatrix(needleMatrix());
+    return node;
+}
@@ -0,0 +1,114 @@
+#ifndef GAUGEITEM_H
+#define GAUGEITEM_H
+
+#include <QColor>
+#include <QMatrix4x4>
+#include <QPolygonF>
+#include <QQuickItem>
+#include <QVector>
+
+// Circular gauge drawn directly in the scene graph. The face (ticks and
+// warning arc) and the hub are static geometry, rebuilt only when the size
+// or the scale changes; the needle sits under a transform node, so a new
+// value only replaces one matrix. Angles follow CircularGauge: degrees,
+// 0 is straight up, positive is clockwise.
+//
+// The software renderer cannot draw custom geometry, so there the face and
+// hub are pre-rendered images and the needle is a rectangle node.
+class GaugeItem : public QQuickItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(qreal value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(qreal minimumValue READ minimumValue WRITE setMinimumValue NOTIFY dialChanged)
+    Q_PROPERTY(qreal maximumValue READ maximumValue WRITE setMaximumValue NOTIFY dialChanged)
+    Q_PROPERTY(qreal minimumValueAngle READ minimumValueAngle WRITE setMinimumValueAngle NOTIFY dialChanged)
+    Q_PROPERTY(qreal maximumValueAngle READ maximumValueAngle WRITE setMaximumValueAngle NOTIFY dialChanged)
+    Q_PROPERTY(qreal tickmarkStepSize READ tickmarkStepSize WRITE setTickmarkStepSize NOTIFY dialChanged)
+    Q_PROPERTY(int minorTickmarkCount READ minorTickmarkCount WRITE setMinorTickmarkCount NOTIFY dialChanged)
+    // Ticks from here up use warningColor and the warning arc is drawn;
+    // below minimumValue disables both.
+    Q_PROPERTY(qreal warningValue READ warningValue WRITE setWarningValue NOTIFY dialChanged)
+    Q_PROPERTY(QColor tickColor READ tickColor WRITE setTickColor NOTIFY dialChanged)
+    Q_PROPERTY(QColor minorTickColor READ minorTickColor WRITE setMinorTickColor NOTIFY dialChanged)
+    Q_PROPERTY(QColor warningColor READ warningColor WRITE setWarningColor NOTIFY dialChanged)
+    Q_PROPERTY(QColor needleColor READ needleColor WRITE setNeedleColor NOTIFY dialChanged)
+    Q_PROPERTY(qreal outerRadius READ outerRadius NOTIFY dialChanged)
+
+public:
+    explicit GaugeItem(QQuickItem *parent = nullptr);
+
+    qreal value() const { return currentValue; }
+    void setValue(qreal newValue);
+
+    qreal minimumValue() const { return minimum; }
+    void setMinimumValue(qreal newMinimum);
+    qreal maximumValue() const { return maximum; }
+    void setMaximumValue(qreal newMaximum);
+    qreal minimumValueAngle() const { return minimumAngle; }
+    void setMinimumValueAngle(qreal angle);
+    qreal maximumValueAngle() const { return maximumAngle; }
+    void setMaximumValueAngle(qreal angle);
+    qreal tickmarkStepSize() const { return tickStep; }
+    void setTickmarkStepSize(qreal step);
+    int minorTickmarkCount() const { return minorCount; }
+    void setMinorTickmarkCount(int count);
+    qreal warningValue() const { return warning; }
+    void setWarningValue(qreal newWarning);
+    QColor tickColor() const { return majorColor; }
+    void setTickColor(const QColor &color);
+    QColor minorTickColor() const { return minorColor; }
+    void setMinorTickColor(const QColor &color);
+    QColor warningColor() const { return alertColor; }
+    void setWarningColor(const QColor &color);
+    QColor needleColor() const { return pointerColor; }
+    void setNeedleColor(const QColor &color);
+
+    qreal outerRadius() const { return qMin(width(), height()) / 2; }
+
+    // For placing labels from QML.
+    Q_INVOKABLE qreal valueToAngle(qreal value) const;
+
+signals:
+    void valueChanged();
+    void dialChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#else
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#endif
+
+private:
+    struct Shape {
+        QPolygonF polygon;
+        QColor color;
+    };
+
+    qreal currentValue;
+    qreal minimum;
+    qreal maximum;
+    qreal minimumAngle;
+    qreal maximumAngle;
+    qreal tickStep;
+    int minorCount;
+    qreal warning;
+    QColor majorColor;
+    QColor minorColor;
+    QColor alertColor;
+    QColor pointerColor;
+    bool scaleDirty;
+
+    void invalidateScale();
+    QVector<Shape> faceShapes() const;
+    QPolygonF hubPolygon() const;
+    QPolygonF needlePolygon() const;
+    QMatrix4x4 needleMatrix() const;
+
+    QSGNode *buildHardwareNodes() const;
+    QSGNode *buildSoftwareNodes() const;
+};
+
+#endif // GAUGEITEM_H
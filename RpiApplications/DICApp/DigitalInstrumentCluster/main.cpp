@@ -1,16 +1,57 @@
+#include <QElapsedTimer>
+#include <QFile>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QTimer>
 #include <QtDBus/QtDBus>
+#include <time.h>
+#include <unistd.h>
+#include "alloctracker.h"
+#include "frametimer.h"
+#include "gaugeitem.h"
 #include "qmlcontroller.h"
 
+#define FRAME_STATS_INTERVAL_MS 5000
+#define ALLOC_REPORT_INTERVAL_MS 5000
+
+// Milliseconds since the kernel started this process, from the start time
+// in /proc/self/stat (clock ticks since boot) and CLOCK_BOOTTIME. Returns
+// -1 when either is unavailable.
+static qint64 msSinceProcessStart()
+{
+    QFile stat(QStringLiteral("/proc/self/stat"));
+    if (!stat.open(QIODevice::ReadOnly))
+        return -1;
+    QByteArray line = stat.readAll();
+    // The command name may contain spaces; fields resume after its ')'.
+    int end = line.lastIndexOf(')');
+    if (end < 0)
+        return -1;
+    QList<QByteArray> fields = line.mid(end + 2).split(' ');
+    // starttime is field 22 of the full line, 20th after the name.
+    if (fields.size() < 20)
+        return -1;
+    long ticks = sysconf(_SC_CLK_TCK);
+    struct timespec now;
+    if (ticks <= 0 || clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+        return -1;
+    qint64 startMs = fields.at(19).toLongLong() * 1000 / ticks;
+    return qint64(now.tv_sec) * 1000 + now.tv_nsec / 1000000 - startMs;
+}
+
 int main(int argc, char *argv[])
 {
+    QElapsedTimer sinceMain;
+    sinceMain.start();
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
     QGuiApplication app(argc, argv);
 
     qmlRegisterType<QmlController>("qml.data", 1, 0, "DataController");
+    qmlRegisterType<GaugeItem>("qml.gauge", 1, 0, "NativeGauge");
 
     QQmlApplicationEngine engine;
     const QUrl url(QStringLiteral("qrc:/main.qml"));
@@ -22,5 +63,40 @@ int main(int argc, char *argv[])
 
     engine.load(url);
 
+    // Startup time is judged by the first frame on screen, not by load().
+    if (!engine.rootObjects().isEmpty())
+    {
+        QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+        if (window)
+        {
+            QMetaObject::Connection *firstFrame = new QMetaObject::Connection;
+            *firstFrame = QObject::connect(window, &QQuickWindow::frameSwapped, &app,
+                                           [firstFrame, sinceMain]() {
+                QObject::disconnect(*firstFrame);
+                delete firstFrame;
+                qDebug() << "First frame :" << sinceMain.elapsed() << "ms after main,"
+                         << msSinceProcessStart() << "ms after process start";
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    // PI_FRAME_STATS=1 logs frame times; combine with QT_QUICK_BACKEND=software
+    // to measure the software renderer.
+    if (!qEnvironmentVariableIsEmpty("PI_FRAME_STATS") && !engine.rootObjects().isEmpty())
+    {
+        QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+        if (window)
+            new FrameTimer(window, FRAME_STATS_INTERVAL_MS, &app);
+    }
+
+#ifdef PI_ALLOC_TRACKING
+    // Totals only grow; a stage whose count stops moving is allocation-free.
+    QTimer allocReport;
+    QObject::connect(&allocReport, &QTimer::timeout, []() {
+        qDebug().noquote() << QString::fromStdString(AllocTracker::report());
+    });
+    allocReport.start(ALLOC_REPORT_INTERVAL_MS);
+#endif
+
     return app.exec();
 }
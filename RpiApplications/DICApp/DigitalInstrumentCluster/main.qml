@@ -6,8 +6,14 @@ Window {
     height: 600
     visible: true
     title: qsTr("Hello World")
-    BackGround {
+    color: "#171717"
 
+    // The gauges come first; the background decodes on a loader thread
+    // and appears behind them once ready.
+    Loader {
+        anchors.fill: parent
+        asynchronous: true
+        source: "qrc:/BackGround.qml"
     }
 
     InstrumentCluster {
@@ -1,61 +1,154 @@
+#include <QtConcurrent>
 #include <QtDBus>
 #include "ServerConfig.h"
+#include "alloctracker.h"
+#include "datamanagerlink.h"
 #include "qmlcontroller.h"
+#include "shmsubscriber.h"
+
+#define TRANSPORT_START_TIMEOUT_MS 500
 
 
 QmlController::QmlController(QObject *parent)
-    : QObject{parent}, rpm(0), rpmTimer(std::make_shared<QTimer>()),
-      batteryTimer(std::make_shared<QTimer>()), tempHumTimer(std::make_shared<QTimer>())
+    : QObject{parent}, rpm(0), humidity(0), temperature(0), battery(0), speed(0),
+      sourceStamp(0), changedFields(0), pending(), pendingSpeed(0), pendingFields(0),
+      flushQueued(false), loopFlushQueued(false), window(nullptr), lastSequence(0), transportStarted(false),
+      dataManager(nullptr), linkName(dataManagerConnectionName("dic", this)),
+      linkWatcher(new QFutureWatcher<bool>(this)), relinkPending(false),
+      serviceWatcher(nullptr), shmSubscriber(nullptr)
 {
     qDBusRegisterMetaType<struct Data>();
-    dataManager = new local::DataManager("pi.chan", "/can/read",
-                                         QDBusConnection::sessionBus(), this);
-
-    connect(rpmTimer.get(), SIGNAL(timeout()), this, SLOT(updateRpm()));
-    connect(batteryTimer.get(), SIGNAL(timeout()), this, SLOT(updateBattery()));
-    connect(tempHumTimer.get(), SIGNAL(timeout()), this, SLOT(updateTempHum()));
+    qDBusRegisterMetaType<struct Snapshot>();
+    connect(linkWatcher, SIGNAL(finished()), this, SLOT(dataManagerLinked()));
 
-    rpmTimer->setInterval(2000);
-    batteryTimer->setInterval(5000);
-    tempHumTimer->setInterval(10000);
+    // Nothing touches the bus while QML is still being created; QML sets
+    // the window property before this queued call runs.
+    QMetaObject::invokeMethod(this, "deferTransport", Qt::QueuedConnection);
+}
 
-    rpmTimer->start();
-    batteryTimer->start();
-    tempHumTimer->start();
+// With a window, the transport starts once the first frame is on screen
+// (or after a short timeout, in case no frame is pending).
+void QmlController::deferTransport()
+{
+    if (!window)
+    {
+        startTransport();
+        return;
+    }
+    connect(window, SIGNAL(frameSwapped()), this, SLOT(startTransport()), Qt::QueuedConnection);
+    QTimer::singleShot(TRANSPORT_START_TIMEOUT_MS, this, SLOT(startTransport()));
 }
 
-void QmlController::updateRpm()
+void QmlController::startTransport()
 {
-    if (!QDBusConnection::sessionBus().isConnected())
+    if (window)
+        disconnect(window, SIGNAL(frameSwapped()), this, SLOT(startTransport()));
+    if (transportStarted)
+        return;
+    transportStarted = true;
+
+    // Local fast path: follow the server's shared-memory segment and keep
+    // D-Bus for control only. PI_TELEMETRY_TRANSPORT=dbus forces D-Bus,
+    // which is itself the peer socket unless PI_DBUS_TRANSPORT=bus.
+    if (qgetenv("PI_TELEMETRY_TRANSPORT") != "dbus")
     {
-        qDebug() << "Bus connected error";
-        return ;
+        shmSubscriber = new ShmSubscriber(this);
+        if (shmSubscriber->open())
+        {
+            connect(shmSubscriber, SIGNAL(telemetryUpdated(uint,Data)),
+                    this, SLOT(updateTelemetry(uint,Data)));
+            shmSubscriber->start();
+            qDebug() << "Telemetry transport : shared memory";
+        }
+        else
+        {
+            delete shmSubscriber;
+            shmSubscriber = nullptr;
+        }
     }
-    QDBusPendingReply<int> reply = dataManager->fetchRpmFromServer();
-    if (!reply.isError())
+
+    openDataManager();
+    // The bus name stays the discovery point: a restarted server shows up
+    // there, and a peer connection to the old one is dead by then.
+    serviceWatcher = new QDBusServiceWatcher(SERVICE_NAME, QDBusConnection::sessionBus(),
+                                             QDBusServiceWatcher::WatchForRegistration, this);
+    connect(serviceWatcher, SIGNAL(serviceRegistered(QString)), this, SLOT(serverRestarted()));
+}
+
+// Direct peer connection when the server offers one, else the session bus.
+// Connecting never blocks the GUI thread: until dataManagerLinked() runs
+// there is no proxy and updateSnapshot() does nothing.
+void QmlController::openDataManager()
+{
+    if (linkWatcher->isRunning())
     {
-        qDebug() << "Rpm data fetch success : " << reply.value();
-        setRpm(reply.value());
+        relinkPending = true;
+        return;
     }
-    else
+    delete dataManager;
+    dataManager = nullptr;
+    linkWatcher->setFuture(QtConcurrent::run(connectDataManagerPeer, linkName));
+}
+
+void QmlController::dataManagerLinked()
+{
+    if (relinkPending)
     {
-        qDebug() << "reply is not valid";
-        qDebug() << reply.error();
+        relinkPending = false;
+        openDataManager();
+        return;
     }
+
+    bool peer = linkWatcher->result();
+    QDBusConnection connection = peer ? QDBusConnection(linkName) : QDBusConnection::sessionBus();
+    dataManager = new local::DataManager(peer ? QString() : SERVICE_NAME, "/can/read", connection, this);
+    qDebug() << "DataManager link :" << (peer ? "peer" : "session bus");
+
+    if (shmSubscriber)
+        return;
+    connect(dataManager, SIGNAL(TelemetryUpdated(uint,Data)),
+            this, SLOT(updateTelemetry(uint,Data)));
+    // The server pushes every change; fetch a full snapshot so the
+    // dashboard does not start empty (a restarted server also counts
+    // sequences from zero again).
+    resetSnapshot();
 }
 
-void QmlController::updateBattery()
+void QmlController::serverRestarted()
 {
-    if (!QDBusConnection::sessionBus().isConnected())
+    openDataManager();
+}
+
+// One round trip per refresh: a full snapshot the first time (or after the
+// server restarted), afterwards only the fields changed since lastSequence.
+// The reply is handled asynchronously, so a slow server never blocks QML.
+void QmlController::updateSnapshot()
+{
+    if (!dataManager)
+        return;
+    if (!dataManager->connection().isConnected())
     {
         qDebug() << "Bus connected error";
         return ;
     }
-    QDBusPendingReply<int> reply = dataManager->fetchBtrLvFromServer();
+    QDBusPendingCall call = lastSequence == 0
+            ? dataManager->fetchSnapshot()
+            : dataManager->fetchChangesSince(lastSequence);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(snapshotReceived(QDBusPendingCallWatcher*)));
+}
+
+void QmlController::snapshotReceived(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<Snapshot> reply = *watcher;
+    watcher->deleteLater();
     if (!reply.isError())
     {
-        qDebug() << "Battery data fetch success : " << reply.value();
-        setBattery(reply.value());
+        Snapshot snapshot = reply.value();
+        qDebug() << "Snapshot fetch success : " << snapshot.sequence;
+        lastSequence = snapshot.sequence;
+        updateTelemetry(snapshot.changed, snapshot.data);
     }
     else
     {
@@ -64,28 +157,121 @@ void QmlController::updateBattery()
     }
 }
 
-void QmlController::updateTempHum()
+void QmlController::resetSnapshot()
 {
-    if (!QDBusConnection::sessionBus().isConnected())
+    lastSequence = 0;
+    updateSnapshot();
+}
+
+void QmlController::updateTelemetry(uint changed, const Data &data)
+{
+    ALLOC_STAGE(AllocStageDicUpdate);
+    pending.stamp = data.stamp;
+    if (changed & DATA_FIELD_BIT(FieldRpm))
+        setRpm(data.rpm);
+    if (changed & DATA_FIELD_BIT(FieldTemp))
+        setTemperature(data.temp);
+    if (changed & DATA_FIELD_BIT(FieldHum))
+        setHumidity(data.hum);
+    if (changed & DATA_FIELD_BIT(FieldBattery))
+        setBattery(data.battery);
+    if (changed & DATA_STAMP_BIT)
+        schedule(DATA_STAMP_BIT);
+}
+
+// Asks for one flush covering everything received until then: the next
+// frame of an exposed window, otherwise the next event-loop pass. A frame
+// requested before the window was hidden never comes, so a hidden window
+// always gets the event-loop flush, whatever was queued before.
+void QmlController::schedule(uint fields)
+{
+    pendingFields |= fields;
+    if (window && window->isExposed())
     {
-        qDebug() << "Bus connected error";
-        return ;
+        if (flushQueued)
+            return;
+        flushQueued = true;
+        window->update();
+        return;
     }
-    QDBusPendingReply<int> temp = dataManager->fetchBtrLvFromServer();
-    QDBusPendingReply<int> hum = dataManager->fetchBtrLvFromServer();
-    if (!temp.isError() && !hum.isError())
+    if (loopFlushQueued)
+        return;
+    flushQueued = true;
+    loopFlushQueued = true;
+    QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+// Runs on the GUI thread from the window's afterAnimating, right before
+// the scene graph synchronizes, so bindings see one consistent update per
+// frame.
+void QmlController::flush()
+{
+    ALLOC_STAGE(AllocStageDicUpdate);
+    flushQueued = false;
+    loopFlushQueued = false;
+    if (!pendingFields)
+        return;
+
+    if (pendingFields & DATA_FIELD_BIT(FieldRpm))
+        rpm = pending.rpm;
+    if (pendingFields & DATA_FIELD_BIT(FieldTemp))
+        temperature = pending.temp;
+    if (pendingFields & DATA_FIELD_BIT(FieldHum))
+        humidity = pending.hum;
+    if (pendingFields & DATA_FIELD_BIT(FieldBattery))
+        battery = pending.battery;
+    if (pendingFields & SpeedChangedBit)
+        speed = pendingSpeed;
+    sourceStamp = pending.stamp;
+    changedFields = pendingFields;
+    pendingFields = 0;
+    emit telemetryChanged();
+}
+
+uint QmlController::getChangedFields() const
+{
+    return changedFields;
+}
+
+QQuickWindow *QmlController::getWindow() const
+{
+    return window;
+}
+
+void QmlController::setWindow(QQuickWindow *newWindow)
+{
+    if (window == newWindow)
+        return;
+    if (window)
     {
-        qDebug() << "Temp data fetch success : " << temp.value();
-        qDebug() << "Hum data fetch success : " << temp.value();
-        setTemperature(temp.value());
-        setTemperature(hum.value());
+        disconnect(window, SIGNAL(afterAnimating()), this, SLOT(flush()));
+        disconnect(window, SIGNAL(visibleChanged(bool)), this, SLOT(reschedule()));
     }
-    else
+    window = newWindow;
+    if (window)
     {
-        qDebug() << "reply is not valid";
-        qDebug() << temp.error();
-        qDebug() << hum.isError();
+        connect(window, SIGNAL(afterAnimating()), this, SLOT(flush()));
+        connect(window, SIGNAL(visibleChanged(bool)), this, SLOT(reschedule()));
     }
+    emit windowChanged();
+
+    // Whatever was queued for the old pacing still needs a flush.
+    reschedule();
+}
+
+// The pacing changed (new window, shown or hidden): a frame requested
+// before may never come, so ask again.
+void QmlController::reschedule()
+{
+    if (!pendingFields)
+        return;
+    flushQueued = false;
+    schedule(0);
+}
+
+qint64 QmlController::getSourceStamp() const
+{
+    return sourceStamp;
 }
 
 int QmlController::getRpm() const
@@ -97,8 +283,8 @@ void QmlController::setRpm(int newRpm)
 {
     if (rpm == newRpm && newRpm < 0)
         return;
-    rpm = newRpm;
-    emit rpmChanged();
+    pending.rpm = newRpm;
+    schedule(DATA_FIELD_BIT(FieldRpm));
 }
 
 int QmlController::getHumidity() const
@@ -110,8 +296,8 @@ void QmlController::setHumidity(int newHumidity)
 {
     if (humidity == newHumidity && newHumidity < 0)
         return;
-    humidity = newHumidity;
-    emit humidityChanged();
+    pending.hum = newHumidity;
+    schedule(DATA_FIELD_BIT(FieldHum));
 }
 
 int QmlController::getTemperature() const
@@ -123,8 +309,8 @@ void QmlController::setTemperature(int newTemperature)
 {
     if (temperature == newTemperature && newTemperature < -20)
         return;
-    temperature = newTemperature;
-    emit temperatureChanged();
+    pending.temp = newTemperature;
+    schedule(DATA_FIELD_BIT(FieldTemp));
 }
 
 int QmlController::getBattery() const
@@ -136,9 +322,8 @@ void QmlController::setBattery(int newBattery)
 {
     if (battery == newBattery && newBattery < 0)
         return;
-    battery = newBattery;
-    qDebug() << "Battery percent : " << battery;
-    emit batteryChanged();
+    pending.battery = newBattery;
+    schedule(DATA_FIELD_BIT(FieldBattery));
 }
 
 int QmlController::getSpeed() const
@@ -150,8 +335,8 @@ void QmlController::setSpeed(int newSpeed)
 {
     if (speed == newSpeed && newSpeed < 0)
         return;
-    speed = newSpeed;
-    emit speedChanged();
+    pendingSpeed = newSpeed;
+    schedule(SpeedChangedBit);
 }
 
 
@@ -1,18 +1,28 @@
 #ifndef QMLCONTROLLER_H
 #define QMLCONTROLLER_H
 
+#include <QDBusPendingCallWatcher>
+#include <QFutureWatcher>
 #include <QObject>
+#include <QQuickWindow>
+#include "ServerConfig.h"
 #include "datamanager_interface.h"
 
 class QmlController : public QObject
 {
     Q_OBJECT
 
-    Q_PROPERTY(int rpm READ getRpm WRITE setRpm NOTIFY rpmChanged)
-    Q_PROPERTY(int humidity READ getHumidity WRITE setHumidity NOTIFY humidityChanged)
-    Q_PROPERTY(int temperature READ getTemperature WRITE setTemperature NOTIFY temperatureChanged)
-    Q_PROPERTY(int battery READ getBattery WRITE setBattery NOTIFY batteryChanged)
-    Q_PROPERTY(int speed READ getSpeed WRITE setSpeed NOTIFY speedChanged)
+    // Every value notifies through telemetryChanged, emitted at most once
+    // per rendered frame; changedFields says which ones moved.
+    Q_PROPERTY(int rpm READ getRpm WRITE setRpm NOTIFY telemetryChanged)
+    Q_PROPERTY(int humidity READ getHumidity WRITE setHumidity NOTIFY telemetryChanged)
+    Q_PROPERTY(int temperature READ getTemperature WRITE setTemperature NOTIFY telemetryChanged)
+    Q_PROPERTY(int battery READ getBattery WRITE setBattery NOTIFY telemetryChanged)
+    Q_PROPERTY(int speed READ getSpeed WRITE setSpeed NOTIFY telemetryChanged)
+    Q_PROPERTY(uint changedFields READ getChangedFields NOTIFY telemetryChanged)
+    // The window whose frames pace the updates. Without one, updates are
+    // still coalesced, but per event-loop pass instead of per frame.
+    Q_PROPERTY(QQuickWindow *window READ getWindow WRITE setWindow NOTIFY windowChanged)
 public:
     explicit QmlController(QObject *parent = nullptr);
 
@@ -31,30 +41,68 @@ public:
     int getSpeed() const;
     void setSpeed(int newSpeed);
 
+    // DATA_FIELD_BIT mask of the last flush; DATA_STAMP_BIT when only the
+    // stamp moved, speed uses SpeedChangedBit.
+    uint getChangedFields() const;
+
+    QQuickWindow *getWindow() const;
+    void setWindow(QQuickWindow *newWindow);
+
+    // Origin time (CLOCK_REALTIME ns) of the newest applied telemetry.
+    qint64 getSourceStamp() const;
+
+    static constexpr uint SpeedChangedBit = DATA_STAMP_BIT << 1;
+
 private:
     int rpm;
     int humidity;
     int temperature;
     int battery;
     int speed;
+    qint64 sourceStamp;
+    uint changedFields;
+
+    // Values received since the last flush, applied together.
+    struct Data pending;
+    int pendingSpeed;
+    uint pendingFields;
+    bool flushQueued;
+    // An event-loop flush is posted; never dropped for a frame request.
+    bool loopFlushQueued;
+    QQuickWindow *window;
+
+    qulonglong lastSequence;
+    bool transportStarted;
 
     local::DataManager *dataManager;
-    std::shared_ptr<class QTimer> rpmTimer;
-    std::shared_ptr<class QTimer> batteryTimer;
-    std::shared_ptr<class QTimer> tempHumTimer;
+    // The peer connect blocks, so it runs on a pool thread; the proxy is
+    // created once it finished. A restart seen meanwhile connects again.
+    QString linkName;
+    QFutureWatcher<bool> *linkWatcher;
+    bool relinkPending;
+    class QDBusServiceWatcher *serviceWatcher;
+    class ShmSubscriber *shmSubscriber;
 
-signals:
-    void rpmChanged();
-    void humidityChanged();
-    void temperatureChanged();
-    void batteryChanged();
+    void schedule(uint fields);
+    void openDataManager();
 
-    void speedChanged();
+signals:
+    void telemetryChanged();
+    void windowChanged();
 
 public slots:
-    void updateRpm();
-    void updateBattery();
-    void updateTempHum();
+    void updateSnapshot();
+    void resetSnapshot();
+    void updateTelemetry(uint changed, const Data &data);
+    void flush();
+
+private slots:
+    void deferTransport();
+    void startTransport();
+    void serverRestarted();
+    void dataManagerLinked();
+    void reschedule();
+    void snapshotReceived(QDBusPendingCallWatcher *watcher);
 
 };
 
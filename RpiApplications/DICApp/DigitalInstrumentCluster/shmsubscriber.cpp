@@ -0,0 +1,88 @@
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <QDebug>
+#include <QSocketNotifier>
+#include "alloctracker.h"
+#include "shmsubscriber.h"
+
+ShmSubscriber::ShmSubscriber(QObject *parent)
+    : QThread{parent}, wakeFD(-1), wakeNotifier(nullptr), pendingChanged(0)
+{
+}
+
+ShmSubscriber::~ShmSubscriber()
+{
+    requestInterruption();
+    wait();
+    delete wakeNotifier;
+    if (wakeFD >= 0)
+        close(wakeFD);
+}
+
+bool ShmSubscriber::open()
+{
+    if (!shm.open(TelemetryShm::Reader))
+        return false;
+
+    wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFD < 0)
+        return false;
+    wakeNotifier = new QSocketNotifier(wakeFD, QSocketNotifier::Read);
+    connect(wakeNotifier, SIGNAL(activated(int)), this, SLOT(deliver()));
+    return true;
+}
+
+void ShmSubscriber::run()
+{
+    Snapshot snapshot;
+    struct Data last = Data();
+    uint32_t seen = shm.notifyCount();
+    bool first = true;
+    const uint64_t wake = 1;
+
+    while (!isInterruptionRequested())
+    {
+        if (!first && !shm.wait(seen, 100))
+            continue;
+        seen = shm.notifyCount();
+        shm.read(snapshot);
+
+        uint changed = first ? DATA_FIELD_ALL : 0;
+        for (int field = 0; field < FieldCount; field++)
+        {
+            if (snapshot.data.field(field) != last.field(field))
+                changed |= DATA_FIELD_BIT(field);
+        }
+        if (snapshot.data.stamp != last.stamp)
+            changed |= DATA_STAMP_BIT;
+        first = false;
+        last = snapshot.data;
+
+        if (changed)
+        {
+            latest.store(snapshot.data);
+            // Several updates before the GUI thread runs collapse into one.
+            if (!pendingChanged.fetch_or(changed, std::memory_order_release) &&
+                    write(wakeFD, &wake, sizeof(wake)) < 0)
+                qWarning() << "Failed to wake the GUI thread";
+        }
+    }
+}
+
+// GUI thread. The mask is taken before the values, so an update racing
+// with it is either included here or wakes the notifier again.
+void ShmSubscriber::deliver()
+{
+    ALLOC_STAGE(AllocStageDicUpdate);
+    uint64_t wakes;
+    if (read(wakeFD, &wakes, sizeof(wakes)) < 0)
+        return;
+
+    uint changed = pendingChanged.exchange(0, std::memory_order_acquire);
+    if (!changed)
+        return;
+    struct Data data;
+    latest.load(data);
+    emit telemetryUpdated(changed, data);
+}
@@ -0,0 +1,46 @@
+#ifndef SHMSUBSCRIBER_H
+#define SHMSUBSCRIBER_H
+
+#include <QThread>
+#include <atomic>
+#include "ServerConfig.h"
+#include "seqlock.h"
+#include "telemetryshm.h"
+
+// Follows the DataManager shared-memory segment from a background thread.
+// The thread sleeps on the segment's futex and, for every new snapshot,
+// publishes the fields that differ from the previous one. It hands them
+// over through a SeqLock and wakes the GUI thread with an eventfd, so the
+// steady state posts no queued events and copies no signal arguments.
+// telemetryUpdated is emitted on the thread owning the subscriber, which
+// must also be the one calling open().
+class ShmSubscriber : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit ShmSubscriber(QObject *parent = nullptr);
+    ~ShmSubscriber();
+
+    bool open();
+
+signals:
+    void telemetryUpdated(uint changed, const Data &data);
+
+protected:
+    void run() override;
+
+private slots:
+    void deliver();
+
+private:
+    TelemetryShm shm;
+    int wakeFD;
+    class QSocketNotifier *wakeNotifier;
+    SeqLock<struct Data> latest;
+    // DATA_FIELD_BIT mask of the fields changed since the last deliver(),
+    // plus DATA_STAMP_BIT when only the stamp moved.
+    std::atomic<uint> pendingChanged;
+};
+
+#endif // SHMSUBSCRIBER_H
@@ -0,0 +1,47 @@
+
+QT += core concurrent dbus quick
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+DBUS_INTERFACES += ../../interfaces/datamanager.xml
+QDBUSXML2CPP_INTERFACE_HEADER_FLAGS += -i ServerConfig.h
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# The QML-side endpoint is the DIC's own controller, so the benchmark
+# measures exactly the code path that drives the dashboard.
+SOURCES += \
+        ../../CanReplay/CanReplay/caninjector.cpp \
+        ../../DICApp/DigitalInstrumentCluster/qmlcontroller.cpp \
+        ../../DICApp/DigitalInstrumentCluster/shmsubscriber.cpp \
+        ../../datamanagerlink.cpp \
+        ../../telemetryshm.cpp \
+        latencybench.cpp \
+        main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+HEADERS += \
+    ../../CanReplay/CanReplay/caninjector.h \
+    ../../DICApp/DigitalInstrumentCluster/qmlcontroller.h \
+    ../../DICApp/DigitalInstrumentCluster/shmsubscriber.h \
+    ../../ServerConfig.h \
+    ../../alloctracker.h \
+    ../../datamanagerlink.h \
+    ../../latencyhistogram.h \
+    ../../seqlock.h \
+    ../../telemetryshm.h \
+    latencybench.h
+
+INCLUDEPATH += ../../ \
+    ../../CanReceiver/CanReceiver/ \
+    ../../CanReplay/CanReplay/ \
+    ../../DICApp/DigitalInstrumentCluster/
+
+LIBS += -lrt -lpthread
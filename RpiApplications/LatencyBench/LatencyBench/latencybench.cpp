@@ -0,0 +1,160 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include "ServerConfig.h"
+#include "candecoder.h"
+#include "caninjector.h"
+#include "qmlcontroller.h"
+#include "latencybench.h"
+
+// Settle time after the last probe so in-flight updates are still counted.
+#define BENCH_DRAIN_MS 500
+// Probe rpm step; larger than the publisher deadband so every probe counts
+// as a change all the way to the QML side.
+#define BENCH_RPM_STEP 10
+#define BENCH_RPM_MAX 5000
+
+static void makeProbe(struct canfd_frame &frame, int rpm, int64_t stampUs)
+{
+    frame.can_id = LATENCY_PROBE_ID;
+    frame.len = CAN_MAX_DLEN;
+    frame.data[0] = uint8_t(rpm >> 8);
+    frame.data[1] = uint8_t(rpm & 0xff);
+    for (int i = 0; i < 6; i++)
+        frame.data[2 + i] = uint8_t(stampUs >> (8 * (5 - i)));
+}
+
+LatencyBench::LatencyBench(QmlController *controller, const QString &ifname,
+                           const QList<double> &rates, int durationMs, QObject *parent)
+    : QObject{parent}, controller(controller), ifname(ifname), rates(rates),
+      durationMs(durationMs), maxP99Ns(0), runIndex(-1), runStartNs(0), received(0),
+      failed(false), injecting(false), sent(0), injectFailed(false)
+{
+    connect(controller, SIGNAL(telemetryChanged()), this, SLOT(recordLatency()));
+}
+
+LatencyBench::~LatencyBench()
+{
+    injecting = false;
+    if (injector.joinable())
+        injector.join();
+}
+
+void LatencyBench::start()
+{
+    if (!csvPath.isEmpty())
+    {
+        QFile csv(csvPath);
+        if (csv.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            QTextStream(&csv) << "rate_hz,sent,received,throughput_hz,p50_us,p99_us,p999_us,max_us\n";
+    }
+    runIndex = -1;
+    startRun();
+}
+
+void LatencyBench::startRun()
+{
+    runIndex++;
+    if (runIndex >= rates.size())
+    {
+        QCoreApplication::exit(failed ? 2 : 0);
+        return;
+    }
+
+    histogram.reset();
+    received = 0;
+    sent = 0;
+    injectFailed = false;
+    runStartNs = currentTimeNs();
+
+    injecting = true;
+    injector = std::thread(&LatencyBench::inject, this, rates[runIndex]);
+    QTimer::singleShot(durationMs, this, SLOT(stopRun()));
+}
+
+// Runs on the injector thread so pacing never waits for the event loop.
+void LatencyBench::inject(double rate)
+{
+    CanInjector can;
+    if (!can.open(ifname.toStdString()))
+    {
+        injectFailed = true;
+        return;
+    }
+
+    FramePacer pacer;
+    pacer.start();
+    double periodNs = 1e9 / rate;
+    struct canfd_frame frame = {};
+
+    for (uint64_t i = 0; injecting.load(std::memory_order_relaxed); i++)
+    {
+        pacer.waitUntil(int64_t(i * periodNs));
+        int rpm = int((i * BENCH_RPM_STEP) % BENCH_RPM_MAX);
+        makeProbe(frame, rpm, currentTimeNs() / 1000);
+        if (!can.send(frame))
+        {
+            injectFailed = true;
+            return;
+        }
+        sent.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LatencyBench::recordLatency()
+{
+    qint64 stamp = controller->getSourceStamp();
+    if (!(controller->getChangedFields() & DATA_FIELD_BIT(FieldRpm)))
+        return;
+    if (runIndex < 0 || stamp < runStartNs)
+        return;
+    histogram.record(currentTimeNs() - stamp);
+    received++;
+}
+
+void LatencyBench::stopRun()
+{
+    injecting = false;
+    if (injector.joinable())
+        injector.join();
+    QTimer::singleShot(BENCH_DRAIN_MS, this, SLOT(reportRun()));
+}
+
+void LatencyBench::reportRun()
+{
+    double rate = rates[runIndex];
+    double seconds = durationMs / 1000.0;
+    double throughput = received / seconds;
+    double p50 = histogram.percentileNs(0.5) / 1000.0;
+    double p99 = histogram.percentileNs(0.99) / 1000.0;
+    double p999 = histogram.percentileNs(0.999) / 1000.0;
+    double maxUs = histogram.maxNs() / 1000.0;
+
+    if (injectFailed)
+    {
+        qDebug() << "Failed to inject on" << ifname;
+        failed = true;
+    }
+
+    qDebug().noquote() << QString("rate %1 Hz | sent %2 | received %3 | %4 updates/s | "
+                                  "p50 %5 us | p99 %6 us | p999 %7 us | max %8 us")
+                          .arg(rate).arg(sent.load()).arg(received).arg(throughput, 0, 'f', 1)
+                          .arg(p50, 0, 'f', 1).arg(p99, 0, 'f', 1).arg(p999, 0, 'f', 1)
+                          .arg(maxUs, 0, 'f', 1);
+
+    if (!csvPath.isEmpty())
+    {
+        QFile csv(csvPath);
+        if (csv.open(QIODevice::WriteOnly | QIODevice::Append))
+            QTextStream(&csv) << rate << "," << sent.load() << "," << received << ","
+                              << throughput << "," << p50 << "," << p99 << ","
+                              << p999 << "," << maxUs << "\n";
+    }
+
+    if (!received || (maxP99Ns > 0 && histogram.percentileNs(0.99) > uint64_t(maxP99Ns)))
+        failed = true;
+
+    startRun();
+}
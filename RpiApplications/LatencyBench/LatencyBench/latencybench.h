@@ -0,0 +1,59 @@
+#ifndef LATENCYBENCH_H
+#define LATENCYBENCH_H
+
+#include <QObject>
+#include <QList>
+#include <atomic>
+#include <thread>
+#include "latencyhistogram.h"
+
+class QmlController;
+
+// Injects latency probe frames on a vcan interface at each configured rate
+// and measures, at the QmlController, the time from injection to the
+// telemetryChanged flush that applies it. Requires CanReceiver
+// (--interface on the same vcan) and ServerApp to be running.
+class LatencyBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    LatencyBench(QmlController *controller, const QString &ifname,
+                 const QList<double> &rates, int durationMs, QObject *parent = nullptr);
+    ~LatencyBench();
+
+    void setCsvPath(const QString &path) { csvPath = path; }
+    void setMaxP99(qint64 maxNs) { maxP99Ns = maxNs; }
+
+public slots:
+    void start();
+
+private slots:
+    void recordLatency();
+    void stopRun();
+    void reportRun();
+
+private:
+    QmlController *controller;
+    QString ifname;
+    QList<double> rates;
+    int durationMs;
+    QString csvPath;
+    qint64 maxP99Ns;
+
+    int runIndex;
+    qint64 runStartNs;
+    uint64_t received;
+    bool failed;
+    LatencyHistogram histogram;
+
+    std::thread injector;
+    std::atomic<bool> injecting;
+    std::atomic<uint64_t> sent;
+    std::atomic<bool> injectFailed;
+
+    void startRun();
+    void inject(double rate);
+};
+
+#endif // LATENCYBENCH_H
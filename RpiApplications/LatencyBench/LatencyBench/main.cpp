@@ -0,0 +1,47 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QTimer>
+#include "qmlcontroller.h"
+#include "latencybench.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("LatencyBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("End-to-end latency from CAN injection to the QmlController "
+                                     "telemetryChanged flush. Run CanReceiver --interface <ifname> "
+                                     "and ServerApp first.");
+    parser.addHelpOption();
+    QCommandLineOption interfaceOption("interface", "vcan interface to inject on.", "ifname", "vcan0");
+    QCommandLineOption ratesOption("rates", "Comma separated probe rates in Hz.", "list", "10,100,500,1000");
+    QCommandLineOption durationOption("duration", "Seconds per rate.", "seconds", "10");
+    QCommandLineOption csvOption("csv", "Also write the results as CSV.", "file");
+    QCommandLineOption gateOption("max-p99", "Exit with status 2 if any p99 exceeds this many us.", "us");
+    parser.addOptions({ interfaceOption, ratesOption, durationOption, csvOption, gateOption });
+    parser.process(a);
+
+    QList<double> rates;
+    for (const QString &rate : parser.value(ratesOption).split(',', Qt::SkipEmptyParts))
+    {
+        if (rate.toDouble() <= 0)
+        {
+            qDebug() << "Invalid rate" << rate;
+            return 1;
+        }
+        rates << rate.toDouble();
+    }
+
+    QmlController controller;
+    LatencyBench bench(&controller, parser.value(interfaceOption), rates,
+                       int(parser.value(durationOption).toDouble() * 1000));
+    if (parser.isSet(csvOption))
+        bench.setCsvPath(parser.value(csvOption));
+    if (parser.isSet(gateOption))
+        bench.setMaxP99(qint64(parser.value(gateOption).toDouble() * 1000));
+
+    QTimer::singleShot(0, &bench, SLOT(start()));
+    return a.exec();
+}
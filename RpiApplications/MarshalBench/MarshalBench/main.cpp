@@ -0,0 +1,22 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "marshalbench.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("MarshalBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Per-update cost of sending Data wrapped in a D-Bus variant "
+                                     "versus as the typed (iiiix) struct. The round-trip phase "
+                                     "needs a session bus.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "Marshalling iterations per encoding.", "n", "200000");
+    QCommandLineOption callsOption("calls", "Round-trip calls per encoding; 0 skips the bus.", "n", "20000");
+    parser.addOptions({ iterationsOption, callsOption });
+    parser.process(a);
+
+    MarshalBench bench(qMax(1, parser.value(iterationsOption).toInt()), parser.value(callsOption).toInt());
+    return bench.run();
+}
@@ -0,0 +1,187 @@
+#include <QDebug>
+#include <QThread>
+#include <time.h>
+#include "marshalbench.h"
+
+// Calls made before each measured round-trip run, so connection setup
+// and first-use type registration are not counted.
+#define BENCH_WARMUP_CALLS 200
+
+static qint64 cpuTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static Data sampleData(int i)
+{
+    Data data;
+    data.rpm = i % 5000;
+    data.temp = 25;
+    data.hum = 50;
+    data.battery = 80;
+    data.stamp = currentTimeNs();
+    return data;
+}
+
+MarshalTarget::MarshalTarget(QObject *parent)
+    : QObject{parent}, last(), calls(0)
+{
+}
+
+bool MarshalTarget::start()
+{
+    QDBusConnection connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus,
+                                                               "marshalbench-target");
+    return connection.registerObject(MARSHAL_BENCH_OBJECT, this, QDBusConnection::ExportAllSlots) &&
+            connection.registerService(MARSHAL_BENCH_SERVICE);
+}
+
+// What DataManager did before the interface was typed.
+void MarshalTarget::saveVariant(QDBusVariant data)
+{
+    last = qdbus_cast<struct Data>(QVariant(data.variant()));
+    calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MarshalTarget::saveTyped(const Data &data)
+{
+    last = data;
+    calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+MarshalBench::MarshalBench(int iterations, int calls)
+    : iterations(iterations), calls(calls)
+{
+}
+
+// The argument as the old client built it, marshalled by itself.
+MarshalBench::Cost MarshalBench::marshalVariant(const Data &data) const
+{
+    qint64 cpuStart = cpuTimeNs();
+    qint64 wallStart = currentTimeNs();
+    for (int i = 0; i < iterations; i++)
+    {
+        QVariant v;
+        v.setValue(data);
+        QDBusVariant wrapped;
+        wrapped.setVariant(v);
+        QDBusArgument argument;
+        argument << wrapped;
+    }
+    return { double(cpuTimeNs() - cpuStart) / iterations, double(currentTimeNs() - wallStart) / iterations };
+}
+
+MarshalBench::Cost MarshalBench::marshalTyped(const Data &data) const
+{
+    qint64 cpuStart = cpuTimeNs();
+    qint64 wallStart = currentTimeNs();
+    for (int i = 0; i < iterations; i++)
+    {
+        QDBusArgument argument;
+        argument << data;
+    }
+    return { double(cpuTimeNs() - cpuStart) / iterations, double(currentTimeNs() - wallStart) / iterations };
+}
+
+MarshalBench::Cost MarshalBench::roundTrip(QDBusConnection &connection, const QString &method,
+                                           bool typed) const
+{
+    qint64 cpuStart = 0;
+    qint64 wallStart = 0;
+    for (int i = -BENCH_WARMUP_CALLS; i < calls; i++)
+    {
+        if (i == 0)
+        {
+            cpuStart = cpuTimeNs();
+            wallStart = currentTimeNs();
+        }
+
+        QDBusMessage call = QDBusMessage::createMethodCall(MARSHAL_BENCH_SERVICE, MARSHAL_BENCH_OBJECT,
+                                                           MARSHAL_BENCH_INTERFACE, method);
+        Data data = sampleData(i);
+        if (typed)
+        {
+            call << QVariant::fromValue(data);
+        }
+        else
+        {
+            QVariant v;
+            v.setValue(data);
+            QDBusVariant wrapped;
+            wrapped.setVariant(v);
+            call << QVariant::fromValue(wrapped);
+        }
+        QDBusMessage reply = connection.call(call);
+        if (reply.type() == QDBusMessage::ErrorMessage)
+        {
+            qDebug() << "Call failed :" << reply.errorMessage();
+            return { -1, -1 };
+        }
+    }
+    return { double(cpuTimeNs() - cpuStart) / calls, double(currentTimeNs() - wallStart) / calls };
+}
+
+void MarshalBench::report(const char *name, const Cost &variant, const Cost &typed)
+{
+    qDebug().noquote() << QString("%1 variant %2 us cpu (%3 us wall) | typed %4 us cpu (%5 us wall) | saved %6 us cpu per update (%7 %)")
+                          .arg(name, -10)
+                          .arg(variant.cpuNs / 1000, 0, 'f', 2).arg(variant.wallNs / 1000, 0, 'f', 2)
+                          .arg(typed.cpuNs / 1000, 0, 'f', 2).arg(typed.wallNs / 1000, 0, 'f', 2)
+                          .arg((variant.cpuNs - typed.cpuNs) / 1000, 0, 'f', 2)
+                          .arg(variant.cpuNs > 0 ? 100 * (variant.cpuNs - typed.cpuNs) / variant.cpuNs : 0, 0, 'f', 1);
+}
+
+int MarshalBench::run()
+{
+    qDBusRegisterMetaType<struct Data>();
+
+    Data data = sampleData(1234);
+    // Alternating order so neither side always runs on a cold cache.
+    Cost variant = marshalVariant(data);
+    Cost typed = marshalTyped(data);
+    Cost variantAgain = marshalVariant(data);
+    Cost typedAgain = marshalTyped(data);
+    variant = { (variant.cpuNs + variantAgain.cpuNs) / 2, (variant.wallNs + variantAgain.wallNs) / 2 };
+    typed = { (typed.cpuNs + typedAgain.cpuNs) / 2, (typed.wallNs + typedAgain.wallNs) / 2 };
+    report("marshal", variant, typed);
+
+    if (calls <= 0)
+        return 0;
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    if (!connection.isConnected())
+    {
+        qDebug() << "No session bus, skipping the round-trip phase";
+        return 0;
+    }
+
+    QThread targetThread;
+    targetThread.setObjectName("marshal-target");
+    MarshalTarget target;
+    target.moveToThread(&targetThread);
+    targetThread.start();
+    bool registered = false;
+    QMetaObject::invokeMethod(&target, "start", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(bool, registered));
+    int status = 0;
+    if (!registered)
+    {
+        qDebug() << "Failed to register" << MARSHAL_BENCH_SERVICE;
+        status = 1;
+    }
+    else
+    {
+        variant = roundTrip(connection, "saveVariant", false);
+        typed = roundTrip(connection, "saveTyped", true);
+        if (variant.cpuNs < 0 || typed.cpuNs < 0)
+            status = 1;
+        else
+            report("round trip", variant, typed);
+    }
+
+    targetThread.quit();
+    targetThread.wait();
+    QDBusConnection::disconnectFromBus("marshalbench-target");
+    return status;
+}
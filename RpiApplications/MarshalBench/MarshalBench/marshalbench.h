@@ -0,0 +1,64 @@
+#ifndef MARSHALBENCH_H
+#define MARSHALBENCH_H
+
+#include <QObject>
+#include <QtDBus>
+#include <atomic>
+#include "ServerConfig.h"
+
+#define MARSHAL_BENCH_SERVICE "pi.chan.marshalbench"
+#define MARSHAL_BENCH_OBJECT "/bench"
+#define MARSHAL_BENCH_INTERFACE "local.MarshalBench"
+
+// Receiving end of the round-trip phase. It runs on its own thread and bus
+// connection and accepts Data in both encodings saveCanDataInServer has
+// used: wrapped in a variant, and as the typed (iiiix) struct.
+class MarshalTarget : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", MARSHAL_BENCH_INTERFACE)
+
+public:
+    explicit MarshalTarget(QObject *parent = nullptr);
+
+    uint64_t received() const { return calls.load(std::memory_order_relaxed); }
+
+public slots:
+    // Runs on the target thread, so the connection belongs to it.
+    bool start();
+
+    void saveVariant(QDBusVariant data);
+    void saveTyped(const Data &data);
+
+private:
+    Data last;
+    std::atomic<uint64_t> calls;
+};
+
+// Compares the per-update cost of the two encodings: client-side
+// marshalling alone, then full blocking calls over the session bus,
+// measured as process CPU time (both ends live in this process).
+class MarshalBench
+{
+public:
+    MarshalBench(int iterations, int calls);
+
+    // Returns the process exit status.
+    int run();
+
+private:
+    struct Cost {
+        double cpuNs;
+        double wallNs;
+    };
+
+    int iterations;
+    int calls;
+
+    Cost marshalVariant(const Data &data) const;
+    Cost marshalTyped(const Data &data) const;
+    Cost roundTrip(QDBusConnection &connection, const QString &method, bool typed) const;
+    static void report(const char *name, const Cost &variant, const Cost &typed);
+};
+
+#endif // MARSHALBENCH_H
@@ -5,16 +5,27 @@ QT += core dbus
 CONFIG += c++17 console
 CONFIG -= app_bundle
 
-DBUS_ADAPTORS += ../../interfaces/datamanager.xml
+DBUS_ADAPTORS += ../../interfaces/datamanager.xml \
+    ../../interfaces/metrics.xml
+QDBUSXML2CPP_ADAPTOR_HEADER_FLAGS += -i ServerConfig.h
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        ../../pipelinemetrics.cpp \
+        ../../printutils.cpp \
+        ../../telemetryshm.cpp \
         datamanager.cpp \
         main.cpp \
-        printutils.cpp
+        telemetryhistory.cpp
+
+# qmake CONFIG+=alloc_tracking counts heap allocations per pipeline stage.
+alloc_tracking {
+    DEFINES += PI_ALLOC_TRACKING
+    SOURCES += ../../alloctracker.cpp
+}
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -23,7 +34,15 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     ../../ServerConfig.h \
+    ../../alloctracker.h \
+    ../../latencyhistogram.h \
+    ../../pipelinemetrics.h \
+    ../../printutils.h \
+    ../../seqlock.h \
+    ../../telemetryshm.h \
     datamanager.h \
-    printutils.h
+    telemetryhistory.h
 
 INCLUDEPATH += ../../
+
+LIBS += -lrt
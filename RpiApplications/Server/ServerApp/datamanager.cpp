@@ -1,47 +1,217 @@
 #include "datamanager.h"
-#include <QDebug>
+#include "printutils.h"
+#include "alloctracker.h"
 #include "datamanager_adaptor.h"
+#include "metrics_adaptor.h"
 #include "ServerConfig.h"
 #include "qdbusargument.h"
 
 DataManager::DataManager(QObject *parent)
-    : QObject{parent}
+    : QObject{parent}, sensorData(), sequence(0), updateStamp(0), fieldSequence(),
+      saveCalls(metrics.counter("server_save_calls_total", "saveCanDataInServer calls handled.")),
+      fetchCalls(metrics.counter("server_fetch_calls_total", "fetch* calls handled.")),
+      publishedUpdates(metrics.counter("server_updates_published_total",
+                                       "Saves that changed a field or the stamp and were pushed to subscribers.")),
+      saveDuration(metrics.histogram("server_save_handler_seconds",
+                                     "Time spent inside saveCanDataInServer.")),
+      sampleAge(metrics.histogram("server_sample_age_seconds",
+                                  "Age of the CAN sample when its save reached the server.")),
+      peerServer(nullptr),
+      peerConnections(metrics.counter("server_peer_connections_total",
+                                      "Direct connections accepted on the peer socket.")),
+      livePeers(0)
 {
     new DataManagerAdaptor(this);
+    new MetricsAdaptor(this);
+    metrics.addCollector([this](MetricsWriter &writer) {
+        writer.gauge("server_sequence", "Current telemetry sequence number.", double(sequence));
+        writer.gauge("server_shm_open", "1 if the shared-memory segment is published.",
+                     shm.isOpen() ? 1 : 0);
+        writer.gauge("server_peer_connections", "Peer socket connections currently open.", livePeers);
+    });
+    connect(&metricsTimer, SIGNAL(timeout()), this, SLOT(dumpMetrics()));
     qDBusRegisterMetaType<struct Data>();
+    qDBusRegisterMetaType<struct Snapshot>();
+    qDBusRegisterMetaType<struct HistoryStats>();
+
+    if (shm.open(TelemetryShm::Writer))
+        LOG_INFO("Telemetry shared memory open : %s", TELEMETRY_SHM_NAME);
+    else
+        LOG_WARN("Telemetry shared memory unavailable, D-Bus only");
 }
 
-void DataManager::saveCanDataInServer(QDBusVariant data)
+void DataManager::saveCanDataInServer(const Data &received)
 {
-    qDebug() << "can data save function called";
-    sensorData = qdbus_cast<struct Data>(QVariant(data.variant()));
+    ALLOC_STAGE(AllocStageServerSave);
+    qint64 handlerStart = currentTimeNs();
+    LOG_DEBUG("can data save function called");
+    saveCalls.add();
+    if (received.stamp)
+        sampleAge.record(handlerStart - received.stamp);
+
+    uint changed = 0;
+    for (int field = 0; field < FieldCount; field++)
+    {
+        if (received.field(field) != sensorData.field(field))
+            changed |= DATA_FIELD_BIT(field);
+    }
+    if (received.stamp != sensorData.stamp)
+        changed |= DATA_STAMP_BIT;
+    sensorData = received;
+    history.append(currentTimeNs(), sensorData);
+
+    // Subscribers get the new values pushed instead of polling fetch*.
+    if (changed)
+    {
+        sequence++;
+        updateStamp = currentTimeNs();
+        for (int field = 0; field < FieldCount; field++)
+        {
+            if (changed & DATA_FIELD_BIT(field))
+                fieldSequence[field] = sequence;
+        }
+        if (shm.isOpen())
+        {
+            Snapshot snapshot = currentSnapshot();
+            snapshot.changed = changed;
+            shm.publish(snapshot);
+        }
+        emit TelemetryUpdated(changed, sensorData);
+        publishedUpdates.add();
+    }
 
-    qDebug() << "rpm : " << sensorData.rpm;
-    qDebug() << "temp : " << sensorData.temp;
-    qDebug() << "hum : " << sensorData.hum;
-    qDebug() << "battery : " << sensorData.battery;
+    LOG_DEBUG("rpm : %d temp : %d hum : %d battery : %d",
+              sensorData.rpm, sensorData.temp, sensorData.hum, sensorData.battery);
+    saveDuration.record(currentTimeNs() - handlerStart);
 }
 
 int DataManager::fetchRpmFromServer()
 {
-    qDebug() << "seding rpm data";
+    LOG_DEBUG("seding rpm data");
+    fetchCalls.add();
     return sensorData.rpm;
 }
 
 int DataManager::fetchTempFromServer()
 {
-    qDebug() << "seding temp data";
+    LOG_DEBUG("seding temp data");
+    fetchCalls.add();
     return sensorData.temp;
 }
 
 int DataManager::fetchHumFromServer()
 {
-    qDebug() << "seding hum data";
+    LOG_DEBUG("seding hum data");
+    fetchCalls.add();
     return sensorData.hum;
 }
 
 int DataManager::fetchBtrLvFromServer()
 {
-    qDebug() << "seding batter data";
+    LOG_DEBUG("seding batter data");
+    fetchCalls.add();
     return sensorData.battery;
 }
+
+Snapshot DataManager::fetchSnapshot()
+{
+    fetchCalls.add();
+    return currentSnapshot();
+}
+
+// Uncounted: also used by saveCanDataInServer and fetchChangesSince.
+Snapshot DataManager::currentSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.sequence = sequence;
+    snapshot.timestamp = updateStamp;
+    snapshot.changed = DATA_FIELD_ALL;
+    snapshot.data = sensorData;
+    return snapshot;
+}
+
+Snapshot DataManager::fetchChangesSince(qulonglong since)
+{
+    fetchCalls.add();
+    Snapshot snapshot = currentSnapshot();
+    snapshot.changed = 0;
+    for (int field = 0; field < FieldCount; field++)
+    {
+        if (fieldSequence[field] > since)
+            snapshot.changed |= DATA_FIELD_BIT(field);
+    }
+    return snapshot;
+}
+
+HistoryStats DataManager::fetchHistory(int field, qlonglong from, qlonglong to)
+{
+    fetchCalls.add();
+    return history.query(field, from, to);
+}
+
+bool DataManager::exportOn(QDBusConnection connection)
+{
+    return connection.registerObject("/can/read", this) &&
+            connection.registerObject("/can/write", this) &&
+            connection.registerObject("/metrics", this);
+}
+
+bool DataManager::listenPeer(const QString &address)
+{
+    peerServer = new QDBusServer(address, this);
+    if (!peerServer->isConnected())
+    {
+        LOG_WARN("Failed to listen on %s : %s", qPrintable(address),
+                 qPrintable(peerServer->lastError().message()));
+        delete peerServer;
+        peerServer = nullptr;
+        return false;
+    }
+    connect(peerServer, SIGNAL(newConnection(QDBusConnection)),
+            this, SLOT(peerConnected(QDBusConnection)));
+    LOG_INFO("Peer socket open : %s", qPrintable(peerServer->address()));
+    return true;
+}
+
+// TelemetryUpdated is relayed on every connection the objects are
+// registered on, so peers get the same pushes as bus subscribers.
+void DataManager::peerConnected(const QDBusConnection &connection)
+{
+    peerConnections.add();
+    livePeers++;
+    QDBusConnection peer(connection);
+    if (!exportOn(peer))
+        LOG_ERROR("Failed to export on peer %s", qPrintable(peer.name()));
+    // libdbus raises this locally when the client goes away.
+    peer.connect(QString(), "/org/freedesktop/DBus/Local", "org.freedesktop.DBus.Local",
+                 "Disconnected", this, SLOT(peerDisconnected()));
+}
+
+// Without this every client restart would leave a dead connection, with
+// the objects registered on it, in QtDBus's connection manager.
+void DataManager::peerDisconnected()
+{
+    if (!calledFromDBus())
+        return;
+    QString name = connection().name();
+    livePeers--;
+    LOG_INFO("Peer disconnected : %s", qPrintable(name));
+    QDBusConnection::disconnectFromPeer(name);
+}
+
+void DataManager::startMetricsDump(const QString &path, int intervalMs)
+{
+    metricsPath = path;
+    metricsTimer.start(intervalMs);
+}
+
+QString DataManager::fetchMetrics()
+{
+    return QString::fromStdString(metrics.prometheusText());
+}
+
+void DataManager::dumpMetrics()
+{
+    if (!metrics.dump(metricsPath.toStdString()))
+        LOG_ERROR("Failed to write metrics : %s", qPrintable(metricsPath));
+}
@@ -2,28 +2,73 @@
 #define DATAMANAGER_H
 
 #include <QObject>
+#include <QTimer>
 #include <QtDBus>
 #include "ServerConfig.h"
+#include "pipelinemetrics.h"
+#include "telemetryhistory.h"
+#include "telemetryshm.h"
 
-class DataManager : public QObject
+// QDBusContext tells peerDisconnected() which peer connection closed.
+class DataManager : public QObject, protected QDBusContext
 {
     Q_OBJECT
 public:
     explicit DataManager(QObject *parent = nullptr);
 
+    void startMetricsDump(const QString &path, int intervalMs);
+    // Registers the DataManager objects on one connection.
+    bool exportOn(QDBusConnection connection);
+    // Also accepts direct connections from local clients on address, so
+    // their calls and signals skip the bus daemon. Only peers running as
+    // the same user pass authentication.
+    bool listenPeer(const QString &address);
+
 private:
     struct Data sensorData;
+    qulonglong sequence;
+    qlonglong updateStamp;
+    qulonglong fieldSequence[FieldCount];
+    TelemetryShm shm;
+    TelemetryHistory history;
+
+    PipelineMetrics metrics;
+    MetricCounter &saveCalls;
+    MetricCounter &fetchCalls;
+    MetricCounter &publishedUpdates;
+    LatencyHistogram &saveDuration;
+    LatencyHistogram &sampleAge;
+    QTimer metricsTimer;
+    QString metricsPath;
+    class QDBusServer *peerServer;
+    MetricCounter &peerConnections;
+    int livePeers;
+
+    Snapshot currentSnapshot() const;
 
 signals:
+    void TelemetryUpdated(uint changed, const Data &data);
 
 public slots:
-    void saveCanDataInServer(QDBusVariant data);
+    // One-way: senders neither wait for nor allocate a reply.
+    Q_NOREPLY void saveCanDataInServer(const Data &received);
 
     int fetchRpmFromServer();
     int fetchTempFromServer();
     int fetchHumFromServer();
     int fetchBtrLvFromServer();
 
+    Snapshot fetchSnapshot();
+    Snapshot fetchChangesSince(qulonglong since);
+    HistoryStats fetchHistory(int field, qlonglong from, qlonglong to);
+
+    QString fetchMetrics();
+    void dumpMetrics();
+
+private slots:
+    void peerConnected(const QDBusConnection &connection);
+    void peerDisconnected();
+
 };
 
 #endif // DATAMANAGER_H
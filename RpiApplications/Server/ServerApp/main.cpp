@@ -1,12 +1,23 @@
 #include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QtDBus/QtDBus>
-#include <QDebug>
 #include "datamanager.h"
+#include "printutils.h"
+
+#define METRICS_DUMP_INTERVAL_MS 5000
 
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption metricsOption("metrics",
+                                     "Periodically write Prometheus text metrics to <file>.",
+                                     "file");
+    parser.addOption(metricsOption);
+    parser.process(a);
+
     QDBusConnection connection = QDBusConnection::sessionBus();
 
     if (!connection.isConnected()) {
@@ -19,15 +30,18 @@ int main(int argc, char *argv[])
 
     DataManager dataManager;
 
-    connection.registerObject("/can/read", &dataManager);
-    connection.registerObject("/can/write", &dataManager);
+    dataManager.exportOn(connection);
+    if (parser.isSet(metricsOption))
+        dataManager.startMetricsDump(parser.value(metricsOption), METRICS_DUMP_INTERVAL_MS);
+    // Before the name is taken: clients reconnect when they see it appear.
+    dataManager.listenPeer(DATAMANAGER_PEER_ADDRESS);
 
     if (!connection.registerService("pi.chan")) {
         fprintf(stderr, "%s\n",
                 qPrintable(QDBusConnection::sessionBus().lastError().message()));
         exit(1);
     }
-    qDebug() << "DBus Server open";
+    LOG_INFO("DBus Server open");
 
 
     return a.exec();
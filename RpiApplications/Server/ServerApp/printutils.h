@@ -1,37 +0,0 @@
-#ifndef PRINTUTILS_H
-#define PRINTUTILS_H
-
-# define COLOR_RED		"\x1b[31m"
-# define COLOR_GREEN	"\x1b[32m"
-# define COLOR_YELLOW	"\x1b[33m"
-# define COLOR_BLUE		"\x1b[34m"
-# define COLOR_MAGENTA	"\x1b[35m"
-# define COLOR_CYAN		"\x1b[36m"
-# define COLOR_WHITE	"\x1b[37m"
-# define COLOR_BRED		"\x1b[91m"
-# define COLOR_BGREEN	"\x1b[92m"
-# define COLOR_BYELLOW	"\x1b[93m"
-# define COLOR_BBLUE	"\x1b[94m"
-# define COLOR_BMAGENTA	"\x1b[95m"
-# define COLOR_BCYAN	"\x1b[96m"
-# define COLOR_RESET	"\x1b[0m"
-
-#include <QString>
-
-class PrintUtils
-{
-public:
-    PrintUtils();
-
-    int PrintErrorText(const QString &errorText, int errorNo);
-    int PrintErrorText(const QString &errorText, int errorNo, int value);
-    void PrintSuccessText(const QString &Text);
-
-    static PrintUtils* getInstance();
-
-private:
-static PrintUtils* instance;
-
-};
-
-#endif // PRINTUTILS_H
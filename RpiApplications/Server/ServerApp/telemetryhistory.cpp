@@ -0,0 +1,195 @@
+#include <limits.h>
+#include "telemetryhistory.h"
+
+static int roundUpPowerOfTwo(int value)
+{
+    int result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+HistoryTier::HistoryTier(int capacity, int64_t bucketNs)
+    : capacity(roundUpPowerOfTwo(capacity)), bucketNs(bucketNs), count(0), next(0),
+      starts(this->capacity, 0), tree(2 * this->capacity, emptyNode())
+{
+}
+
+HistoryTier::Node HistoryTier::emptyNode()
+{
+    Node node;
+    node.sum = 0;
+    node.lastNs = INT64_MIN;
+    node.minimum = INT_MAX;
+    node.maximum = INT_MIN;
+    node.last = 0;
+    node.count = 0;
+    return node;
+}
+
+void HistoryTier::merge(Node &into, const Node &from)
+{
+    if (!from.count)
+        return;
+    into.sum += from.sum;
+    into.count += from.count;
+    if (from.minimum < into.minimum)
+        into.minimum = from.minimum;
+    if (from.maximum > into.maximum)
+        into.maximum = from.maximum;
+    if (from.lastNs >= into.lastNs)
+    {
+        into.lastNs = from.lastNs;
+        into.last = from.last;
+    }
+}
+
+void HistoryTier::update(int slot, const Node &leaf)
+{
+    int index = slot + capacity;
+    tree[index] = leaf;
+    for (index >>= 1; index >= 1; index >>= 1)
+    {
+        Node node = tree[2 * index];
+        merge(node, tree[2 * index + 1]);
+        tree[index] = node;
+    }
+}
+
+void HistoryTier::append(int64_t stampNs, int value)
+{
+    Node sample = emptyNode();
+    sample.sum = value;
+    sample.lastNs = stampNs;
+    sample.minimum = value;
+    sample.maximum = value;
+    sample.last = value;
+    sample.count = 1;
+
+    int64_t start = bucketNs ? stampNs - stampNs % bucketNs : stampNs;
+
+    // Same bucket as the newest one: fold the sample into it.
+    if (bucketNs && count && starts[physical(count - 1)] == start)
+    {
+        int slot = physical(count - 1);
+        Node leaf = tree[slot + capacity];
+        merge(leaf, sample);
+        update(slot, leaf);
+        return;
+    }
+
+    starts[next] = start;
+    update(next, sample);
+    next = (next + 1) & (capacity - 1);
+    if (count < capacity)
+        count++;
+}
+
+bool HistoryTier::covers(int64_t fromNs) const
+{
+    return count == capacity ? starts[physical(0)] <= fromNs : count > 0;
+}
+
+// First logical bucket whose start is >= stampNs.
+int HistoryTier::lowerBound(int64_t stampNs) const
+{
+    int low = 0;
+    int high = count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (starts[physical(mid)] < stampNs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+void HistoryTier::queryRange(int first, int last, Node &result) const
+{
+    for (int l = first + capacity, r = last + capacity + 1; l < r; l >>= 1, r >>= 1)
+    {
+        if (l & 1)
+            merge(result, tree[l++]);
+        if (r & 1)
+            merge(result, tree[--r]);
+    }
+}
+
+HistoryStats HistoryTier::query(int64_t fromNs, int64_t toNs) const
+{
+    HistoryStats stats = HistoryStats();
+    stats.from = fromNs;
+    stats.to = toNs;
+
+    // Buckets overlapping [fromNs, toNs]: start > fromNs - width, start <= toNs.
+    // Both bounds saturate, so [INT64_MIN, INT64_MAX] selects every bucket.
+    int64_t width = bucketNs ? bucketNs : 1;
+    int first = fromNs < INT64_MIN + width ? 0 : lowerBound(fromNs - width + 1);
+    int last = toNs == INT64_MAX ? count - 1 : lowerBound(toNs + 1) - 1;
+    if (first > last)
+        return stats;
+
+    Node result = emptyNode();
+    int physFirst = physical(first);
+    int physLast = physical(last);
+    if (physFirst <= physLast)
+        queryRange(physFirst, physLast, result);
+    else
+    {
+        queryRange(physFirst, capacity - 1, result);
+        queryRange(0, physLast, result);
+    }
+
+    if (result.count)
+    {
+        stats.minimum = result.minimum;
+        stats.maximum = result.maximum;
+        stats.mean = double(result.sum) / result.count;
+        stats.last = result.last;
+        stats.count = result.count;
+    }
+    return stats;
+}
+
+TelemetryHistory::Series::Series()
+    : raw(HISTORY_RAW_CAPACITY, 0),
+      seconds(HISTORY_SECOND_CAPACITY, int64_t(1000000000)),
+      minutes(HISTORY_MINUTE_CAPACITY, int64_t(60) * 1000000000)
+{
+}
+
+TelemetryHistory::TelemetryHistory()
+    : series(FieldCount)
+{
+}
+
+void TelemetryHistory::append(int64_t stampNs, const struct Data &data)
+{
+    for (int field = 0; field < FieldCount; field++)
+    {
+        int value = data.field(field);
+        series[field].raw.append(stampNs, value);
+        series[field].seconds.append(stampNs, value);
+        series[field].minutes.append(stampNs, value);
+    }
+}
+
+HistoryStats TelemetryHistory::query(int field, int64_t fromNs, int64_t toNs) const
+{
+    if (field < 0 || field >= FieldCount || fromNs > toNs)
+    {
+        HistoryStats stats = HistoryStats();
+        stats.from = fromNs;
+        stats.to = toNs;
+        return stats;
+    }
+
+    const Series &s = series[field];
+    if (s.raw.covers(fromNs))
+        return s.raw.query(fromNs, toNs);
+    if (s.seconds.covers(fromNs))
+        return s.seconds.query(fromNs, toNs);
+    return s.minutes.query(fromNs, toNs);
+}
@@ -0,0 +1,73 @@
+#ifndef TELEMETRYHISTORY_H
+#define TELEMETRYHISTORY_H
+
+#include <stdint.h>
+#include <vector>
+#include "ServerConfig.h"
+
+#define HISTORY_RAW_CAPACITY 16384
+#define HISTORY_SECOND_CAPACITY 4096
+#define HISTORY_MINUTE_CAPACITY 2048
+
+// Fixed-size ring of time buckets with a segment tree of aggregates laid
+// over the ring slots. bucketNs == 0 keeps one bucket per sample (full
+// rate). Appending and querying a time range are both O(log n) and no
+// memory is allocated after construction.
+class HistoryTier
+{
+public:
+    HistoryTier(int capacity, int64_t bucketNs);
+
+    void append(int64_t stampNs, int value);
+    bool covers(int64_t fromNs) const;
+    HistoryStats query(int64_t fromNs, int64_t toNs) const;
+
+private:
+    struct Node {
+        int64_t sum;
+        int64_t lastNs;
+        int minimum;
+        int maximum;
+        int last;
+        uint32_t count;
+    };
+
+    int capacity;
+    int64_t bucketNs;
+    int count;
+    int next;
+    std::vector<int64_t> starts;
+    std::vector<Node> tree;
+
+    static Node emptyNode();
+    static void merge(Node &into, const Node &from);
+
+    int physical(int logical) const { return (next - count + logical + capacity) & (capacity - 1); }
+    int lowerBound(int64_t stampNs) const;
+    void update(int slot, const Node &leaf);
+    void queryRange(int first, int last, Node &result) const;
+};
+
+// Full-rate samples for the last few minutes plus 1 s and 1 min tiers for
+// longer windows, one set per Data field. Queries use the finest tier that
+// still reaches back to the start of the requested window.
+class TelemetryHistory
+{
+public:
+    TelemetryHistory();
+
+    void append(int64_t stampNs, const struct Data &data);
+    HistoryStats query(int field, int64_t fromNs, int64_t toNs) const;
+
+private:
+    struct Series {
+        Series();
+        HistoryTier raw;
+        HistoryTier seconds;
+        HistoryTier minutes;
+    };
+
+    std::vector<Series> series;
+};
+
+#endif // TELEMETRYHISTORY_H
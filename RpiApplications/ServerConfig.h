@@ -4,14 +4,55 @@
 #include <QObject>
 #include <QMetaType>
 #include <QtDBus>
+#include <time.h>
 
 #define SERVICE_NAME "pi.chan"
+// Private peer-to-peer socket of the DataManager, next to the bus name.
+// Abstract, so nothing is left on disk when the server dies.
+#define DATAMANAGER_PEER_ADDRESS "unix:abstract=pi.chan.datamanager"
+
+// Index of each telemetry value inside struct Data. Decoders and publishers
+// use (1u << field) masks to describe which values a frame or update touched.
+enum DataField {
+    FieldRpm = 0,
+    FieldTemp,
+    FieldHum,
+    FieldBattery,
+    FieldCount
+};
+
+#define DATA_FIELD_BIT(field) (1u << (field))
+#define DATA_FIELD_ALL ((1u << FieldCount) - 1)
+// Set in an update mask when Data::stamp advanced, even if no value moved:
+// the same readings were sampled again.
+#define DATA_STAMP_BIT (1u << FieldCount)
 
 struct Data {
     int rpm;
     int temp;
     int hum;
     int battery;
+    // CLOCK_REALTIME ns of the newest value. For sequenced, sender-stamped
+    // frames it is the sender's sampling time mapped onto our clock by
+    // TelemetryStream; otherwise the kernel RX time of the frame, the
+    // injection time of a latency probe, or the battery read time.
+    qint64 stamp;
+
+    int &field(int index)
+    {
+        switch (index)
+        {
+        case FieldRpm: return rpm;
+        case FieldTemp: return temp;
+        case FieldHum: return hum;
+        default: return battery;
+        }
+    }
+
+    int field(int index) const
+    {
+        return const_cast<Data *>(this)->field(index);
+    }
 
     friend QDBusArgument &operator<<(QDBusArgument &arg, const struct Data &data)
     {
@@ -20,6 +61,7 @@ struct Data {
         arg << data.temp;
         arg << data.hum;
         arg << data.battery;
+        arg << data.stamp;
         arg.endStructure();
         return arg;
     }
@@ -27,11 +69,11 @@ struct Data {
     friend const QDBusArgument &operator>>(const QDBusArgument &arg, struct Data &data)
     {
         arg.beginStructure();
-        qDebug() << "najsndjansd";
         arg >> data.rpm;
         arg >> data.temp;
         arg >> data.hum;
         arg >> data.battery;
+        arg >> data.stamp;
         arg.endStructure();
         return arg;
     }
@@ -40,6 +82,90 @@ struct Data {
 
 Q_DECLARE_METATYPE(Data);
 
+// One consistent view of the server state. sequence increases with every
+// change, timestamp is the CLOCK_REALTIME time of that change in ns and
+// changed is the DATA_FIELD_BIT mask of fields that are valid in data
+// (all of them for fetchSnapshot, the updated ones for fetchChangesSince).
+struct Snapshot {
+    qulonglong sequence;
+    qlonglong timestamp;
+    uint changed;
+    struct Data data;
+
+    friend QDBusArgument &operator<<(QDBusArgument &arg, const struct Snapshot &snapshot)
+    {
+        arg.beginStructure();
+        arg << snapshot.sequence;
+        arg << snapshot.timestamp;
+        arg << snapshot.changed;
+        arg << snapshot.data;
+        arg.endStructure();
+        return arg;
+    }
+
+    friend const QDBusArgument &operator>>(const QDBusArgument &arg, struct Snapshot &snapshot)
+    {
+        arg.beginStructure();
+        arg >> snapshot.sequence;
+        arg >> snapshot.timestamp;
+        arg >> snapshot.changed;
+        arg >> snapshot.data;
+        arg.endStructure();
+        return arg;
+    }
+};
+
+Q_DECLARE_METATYPE(Snapshot);
+
+// Aggregates of one field over [from, to] (CLOCK_REALTIME ns), as answered
+// by DataManager::fetchHistory. count is 0 when no sample fell in range.
+struct HistoryStats {
+    qlonglong from;
+    qlonglong to;
+    int minimum;
+    int maximum;
+    double mean;
+    int last;
+    uint count;
+
+    friend QDBusArgument &operator<<(QDBusArgument &arg, const struct HistoryStats &stats)
+    {
+        arg.beginStructure();
+        arg << stats.from;
+        arg << stats.to;
+        arg << stats.minimum;
+        arg << stats.maximum;
+        arg << stats.mean;
+        arg << stats.last;
+        arg << stats.count;
+        arg.endStructure();
+        return arg;
+    }
+
+    friend const QDBusArgument &operator>>(const QDBusArgument &arg, struct HistoryStats &stats)
+    {
+        arg.beginStructure();
+        arg >> stats.from;
+        arg >> stats.to;
+        arg >> stats.minimum;
+        arg >> stats.maximum;
+        arg >> stats.mean;
+        arg >> stats.last;
+        arg >> stats.count;
+        arg.endStructure();
+        return arg;
+    }
+};
+
+Q_DECLARE_METATYPE(HistoryStats);
+
+static inline qint64 currentTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
 
 
 #endif // SERVERCONFIG_H
@@ -0,0 +1,120 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include "alloctracker.h"
+
+// glibc's own entry points; the definitions below interpose the public
+// names for the whole process, shared libraries included.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+}
+
+// Constant-initialized, so neither needs an allocation before the first
+// malloc can be counted.
+static thread_local int currentStage = AllocStageOther;
+static std::atomic<uint64_t> stageCounts[AllocStageCount];
+static std::atomic<uint64_t> stageBytes[AllocStageCount];
+
+static inline void note(size_t size)
+{
+    int stage = currentStage;
+    stageCounts[stage].fetch_add(1, std::memory_order_relaxed);
+    stageBytes[stage].fetch_add(size, std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    note(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    note(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    note(size);
+    return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    note(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    note(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+    note(size);
+    void *block = __libc_memalign(alignment, size);
+    if (!block)
+        return ENOMEM;
+    *pointer = block;
+    return 0;
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+
+}
+
+int AllocTracker::enter(int stage)
+{
+    int previous = currentStage;
+    currentStage = stage;
+    return previous;
+}
+
+void AllocTracker::leave(int previous)
+{
+    currentStage = previous;
+}
+
+uint64_t AllocTracker::count(int stage)
+{
+    return stageCounts[stage].load(std::memory_order_relaxed);
+}
+
+uint64_t AllocTracker::bytes(int stage)
+{
+    return stageBytes[stage].load(std::memory_order_relaxed);
+}
+
+const char *AllocTracker::stageName(int stage)
+{
+    static const char *const names[AllocStageCount] = {
+        "other", "can_read", "can_publish", "battery", "server_save", "dic_update", "dic_render"
+    };
+    return stage >= 0 && stage < AllocStageCount ? names[stage] : "unknown";
+}
+
+std::string AllocTracker::report()
+{
+    std::string text = "allocations";
+    for (int stage = 0; stage < AllocStageCount; stage++)
+    {
+        char part[96];
+        snprintf(part, sizeof(part), " | %s %llu (%llu B)", stageName(stage),
+                 (unsigned long long)count(stage), (unsigned long long)bytes(stage));
+        text += part;
+    }
+    return text;
+}
@@ -0,0 +1,56 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <stdint.h>
+#include <string>
+
+// Pipeline stages heap allocations are charged to. Code outside any
+// ALLOC_STAGE scope counts as AllocStageOther.
+enum AllocStage {
+    AllocStageOther = 0,
+    AllocStageCanRead,
+    AllocStageCanPublish,
+    AllocStageBattery,
+    AllocStageServerSave,
+    AllocStageDicUpdate,
+    AllocStageDicRender,
+    AllocStageCount
+};
+
+// Build with qmake CONFIG+=alloc_tracking to count every malloc, calloc
+// and realloc (operator new included, it allocates through malloc) per
+// thread-local stage. In normal builds ALLOC_STAGE compiles to nothing.
+#ifdef PI_ALLOC_TRACKING
+
+class AllocTracker
+{
+public:
+    static int enter(int stage);
+    static void leave(int previous);
+
+    static uint64_t count(int stage);
+    static uint64_t bytes(int stage);
+    static const char *stageName(int stage);
+    // One line with the totals of every stage.
+    static std::string report();
+};
+
+class AllocStageScope
+{
+public:
+    explicit AllocStageScope(int stage) : previous(AllocTracker::enter(stage)) {}
+    ~AllocStageScope() { AllocTracker::leave(previous); }
+
+private:
+    int previous;
+};
+
+# define ALLOC_STAGE(stage) AllocStageScope allocStageScope(stage)
+
+#else
+
+# define ALLOC_STAGE(stage) do {} while (0)
+
+#endif
+
+#endif // ALLOCTRACKER_H
@@ -0,0 +1,27 @@
+#include "ServerConfig.h"
+#include "datamanagerlink.h"
+
+QString dataManagerConnectionName(const QString &caller, const void *owner)
+{
+    return QString("%1-datamanager-%2").arg(caller).arg(quintptr(owner), 0, 16);
+}
+
+bool connectDataManagerPeer(const QString &connectionName)
+{
+    // Reusing a name returns the connection still registered under it,
+    // which is dead once its server went away.
+    QDBusConnection::disconnectFromPeer(connectionName);
+    if (qgetenv("PI_DBUS_TRANSPORT") == "bus")
+        return false;
+
+    if (QDBusConnection::connectToPeer(DATAMANAGER_PEER_ADDRESS, connectionName).isConnected())
+        return true;
+    QDBusConnection::disconnectFromPeer(connectionName);
+    return false;
+}
+
+QDBusConnection connectDataManager(const QString &connectionName, bool &peer)
+{
+    peer = connectDataManagerPeer(connectionName);
+    return peer ? QDBusConnection(connectionName) : QDBusConnection::sessionBus();
+}
@@ -0,0 +1,25 @@
+#ifndef DATAMANAGERLINK_H
+#define DATAMANAGERLINK_H
+
+#include <QString>
+#include <QtDBus>
+
+// A connection name of its own for every proxy owner (caller plus owner
+// address), so two owners in one process never drop each other's link.
+QString dataManagerConnectionName(const QString &caller, const void *owner);
+
+// Drops connectionName and reopens it on the server's peer socket
+// (DATAMANAGER_PEER_ADDRESS); the connection is then
+// QDBusConnection(connectionName). Returns false, leaving nothing
+// registered, when the socket does not accept or PI_DBUS_TRANSPORT=bus.
+// Blocks until the server answers but may run on any thread, so a GUI
+// can call it from a worker.
+bool connectDataManagerPeer(const QString &connectionName);
+
+// Opens the connection a DataManager proxy should use: the peer socket
+// when it accepts one, otherwise the session bus. peer tells which one it
+// is: calls on a peer connection are addressed to an empty service name.
+// Calling it again after the server restarted reconnects.
+QDBusConnection connectDataManager(const QString &connectionName, bool &peer);
+
+#endif // DATAMANAGERLINK_H
@@ -0,0 +1,104 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Log-linear histogram of non-negative durations in nanoseconds: 16
+// sub-buckets per power of two (about 6 % resolution) up to 2^40 ns.
+// record() is one relaxed atomic add, so several threads may record
+// concurrently; readers get an approximate but consistent-enough view.
+class LatencyHistogram
+{
+public:
+    static const int SubBucketBits = 4;
+    static const int SubBuckets = 1 << SubBucketBits;
+    static const int MaxExponent = 40;
+    static const int BucketCount = (MaxExponent - SubBucketBits + 1) * SubBuckets + SubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void reset()
+    {
+        for (int i = 0; i < BucketCount; i++)
+            buckets[i].store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    void record(int64_t valueNs)
+    {
+        uint64_t value = valueNs < 0 ? 0 : uint64_t(valueNs);
+        buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+            ;
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sumNs() const { return sum.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return maximum.load(std::memory_order_relaxed); }
+    double meanNs() const { return count() ? double(sumNs()) / count() : 0.0; }
+
+    // Value at quantile q (0..1), reported as the midpoint of its bucket.
+    uint64_t percentileNs(double q) const
+    {
+        uint64_t n = count();
+        if (!n)
+            return 0;
+        uint64_t rank = uint64_t(q * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; i++)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                uint64_t mid = (lowerBound(i) + upperBound(i)) / 2;
+                return mid < maxNs() ? mid : maxNs();
+            }
+        }
+        return maxNs();
+    }
+
+    // Number of values in [lowerBound(i), upperBound(i)], for exports.
+    uint64_t bucketCount(int i) const { return buckets[i].load(std::memory_order_relaxed); }
+
+    static int bucketOf(uint64_t value)
+    {
+        if (value < uint64_t(SubBuckets))
+            return int(value);
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent > MaxExponent)
+            return BucketCount - 1;
+        int sub = int((value >> (exponent - SubBucketBits)) & (SubBuckets - 1));
+        return (exponent - SubBucketBits + 1) * SubBuckets + sub;
+    }
+
+    static uint64_t lowerBound(int index)
+    {
+        if (index < SubBuckets)
+            return uint64_t(index);
+        int exponent = index / SubBuckets + SubBucketBits - 1;
+        uint64_t sub = uint64_t(index % SubBuckets);
+        return (SubBuckets + sub) << (exponent - SubBucketBits);
+    }
+
+    static uint64_t upperBound(int index)
+    {
+        if (index < SubBuckets)
+            return uint64_t(index);
+        int exponent = index / SubBuckets + SubBucketBits - 1;
+        return lowerBound(index) + (uint64_t(1) << (exponent - SubBucketBits)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> buckets[BucketCount];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maximum;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloctracker.h"
+#include "pipelinemetrics.h"
+
+void MetricsWriter::header(const std::string &name, const std::string &help, const char *type)
+{
+    if (name == lastName)
+        return;
+    lastName = name;
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+void MetricsWriter::sample(const std::string &name, const std::string &labels, double value)
+{
+    char number[32];
+    snprintf(number, sizeof(number), "%.9g", value);
+    out += name;
+    if (!labels.empty())
+        out += "{" + labels + "}";
+    out += " ";
+    out += number;
+    out += "\n";
+}
+
+void MetricsWriter::counter(const std::string &name, const std::string &help, uint64_t value,
+                            const std::string &labels)
+{
+    header(name, help, "counter");
+    sample(name, labels, double(value));
+}
+
+void MetricsWriter::gauge(const std::string &name, const std::string &help, double value,
+                          const std::string &labels)
+{
+    header(name, help, "gauge");
+    sample(name, labels, value);
+}
+
+void MetricsWriter::summary(const std::string &name, const std::string &help,
+                            const LatencyHistogram &histogram)
+{
+    static const char *const quantiles[] = { "0.5", "0.9", "0.99", "0.999" };
+
+    header(name, help, "summary");
+    for (const char *quantile : quantiles)
+    {
+        double value = histogram.percentileNs(atof(quantile)) / 1e9;
+        sample(name, std::string("quantile=\"") + quantile + "\"", value);
+    }
+    sample(name, "quantile=\"1\"", histogram.maxNs() / 1e9);
+    sample(name + "_sum", std::string(), histogram.sumNs() / 1e9);
+    sample(name + "_count", std::string(), double(histogram.count()));
+}
+
+MetricCounter &PipelineMetrics::counter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Entry entry;
+    entry.name = name;
+    entry.help = help;
+    entry.counter.reset(new MetricCounter());
+    entries.push_back(std::move(entry));
+    return *entries.back().counter;
+}
+
+LatencyHistogram &PipelineMetrics::histogram(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Entry entry;
+    entry.name = name;
+    entry.help = help;
+    entry.histogram.reset(new LatencyHistogram());
+    entries.push_back(std::move(entry));
+    return *entries.back().histogram;
+}
+
+void PipelineMetrics::addCollector(const Collector &collector)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    collectors.push_back(collector);
+}
+
+std::string PipelineMetrics::prometheusText() const
+{
+    std::string text;
+    MetricsWriter writer(text);
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (const Entry &entry : entries)
+    {
+        if (entry.counter)
+            writer.counter(entry.name, entry.help, entry.counter->load());
+        else
+            writer.summary(entry.name, entry.help, *entry.histogram);
+    }
+    for (const Collector &collector : collectors)
+        collector(writer);
+#ifdef PI_ALLOC_TRACKING
+    for (int stage = 0; stage < AllocStageCount; stage++)
+        writer.counter("process_allocations_total", "Heap allocations per pipeline stage.",
+                       AllocTracker::count(stage), std::string("stage=\"") + AllocTracker::stageName(stage) + "\"");
+    for (int stage = 0; stage < AllocStageCount; stage++)
+        writer.counter("process_allocated_bytes_total", "Bytes requested from the heap per pipeline stage.",
+                       AllocTracker::bytes(stage), std::string("stage=\"") + AllocTracker::stageName(stage) + "\"");
+#endif
+    return text;
+}
+
+bool PipelineMetrics::dump(const std::string &path) const
+{
+    std::string text = prometheusText();
+    std::string temporary = path + ".tmp";
+
+    FILE *file = fopen(temporary.c_str(), "w");
+    if (!file)
+        return false;
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (fclose(file) != 0 || !written)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
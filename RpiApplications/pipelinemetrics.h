@@ -0,0 +1,81 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "latencyhistogram.h"
+
+// Monotonic event count; add() is a single relaxed atomic increment, so it
+// is safe on any thread, including the CAN reader.
+class MetricCounter
+{
+public:
+    MetricCounter() : value(0) {}
+
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t load() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value;
+};
+
+// Appends samples in the Prometheus text exposition format. Consecutive
+// samples with the same name share one HELP/TYPE header, so labelled
+// series must be written together.
+class MetricsWriter
+{
+public:
+    explicit MetricsWriter(std::string &out) : out(out) {}
+
+    void counter(const std::string &name, const std::string &help, uint64_t value,
+                 const std::string &labels = std::string());
+    void gauge(const std::string &name, const std::string &help, double value,
+               const std::string &labels = std::string());
+    // Exported as a summary in seconds with p50/p90/p99/p999 and the maximum.
+    void summary(const std::string &name, const std::string &help, const LatencyHistogram &histogram);
+
+private:
+    std::string &out;
+    std::string lastName;
+
+    void header(const std::string &name, const std::string &help, const char *type);
+    void sample(const std::string &name, const std::string &labels, double value);
+};
+
+// Per-process metrics registry. Counters and histograms it owns keep their
+// address for the registry's lifetime, so hot paths hold plain pointers and
+// never touch the registry lock. Collectors export state that already
+// lives elsewhere (reader atomics, filter counts) at render time.
+class PipelineMetrics
+{
+public:
+    typedef std::function<void(MetricsWriter &)> Collector;
+
+    MetricCounter &counter(const std::string &name, const std::string &help);
+    LatencyHistogram &histogram(const std::string &name, const std::string &help);
+    void addCollector(const Collector &collector);
+
+    std::string prometheusText() const;
+    // Written to a temporary file and renamed, so a scraper never sees a
+    // partial dump.
+    bool dump(const std::string &path) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<LatencyHistogram> histogram;
+    };
+
+    mutable std::mutex lock;
+    std::vector<Entry> entries;
+    std::vector<Collector> collectors;
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,231 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include "printutils.h"
+
+# define LOG_WRITE_BATCH 64
+
+static long futex(std::atomic<uint32_t> *word, int op, uint32_t value)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, NULL, NULL, 0);
+}
+
+PrintUtils* PrintUtils::instance;
+
+PrintUtils::PrintUtils()
+    : head(0), tail(0), written(0), dropped(0), running(true), writerSleeping(0), wakeups(0),
+      drained(0), flushWaiters(0)
+{
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    // Timestamp prefix plus two color codes per message.
+    batch.reserve(LOG_WRITE_BATCH * (LOG_TEXT_MAX + 32));
+    writer = std::thread(&PrintUtils::writeLoop, this);
+}
+
+PrintUtils::~PrintUtils()
+{
+    running = false;
+    wakeWriter();
+    if (writer.joinable())
+        writer.join();
+}
+
+int PrintUtils::PrintErrorText(const QString &errorText, int errorNo)
+{
+    LOG_ERROR("%s", qPrintable(errorText));
+    return errorNo;
+}
+
+int PrintUtils::PrintErrorText(const QString &errorText, int errorNo, int value)
+{
+    LOG_ERROR("%s : %d", qPrintable(errorText), value);
+    return errorNo;
+}
+
+void PrintUtils::PrintSuccessText(const QString &Text)
+{
+    LOG_INFO("%s", qPrintable(Text));
+}
+
+void PrintUtils::log(int level, const char *format, ...)
+{
+    uint64_t ticket = head.load(std::memory_order_relaxed);
+    Record *record;
+    for (;;)
+    {
+        record = &ring[ticket % LOG_RING_SIZE];
+        uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence == ticket)
+        {
+            if (head.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (sequence < ticket)
+        {
+            // The writer has not freed this slot yet: the ring is full.
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            ticket = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record->stampNs = int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+    record->level = level;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record->text, sizeof(record->text), format, args);
+    va_end(args);
+
+    record->sequence.store(ticket + 1, std::memory_order_release);
+
+    // Pairs with the fence in waitForRecords(): either the writer sees this
+    // record before parking, or this sees it parked. The system call is
+    // only paid on the idle to busy transition.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load(std::memory_order_relaxed))
+        wakeWriter();
+}
+
+void PrintUtils::wakeWriter()
+{
+    wakeups.fetch_add(1, std::memory_order_seq_cst);
+    futex(&wakeups, FUTEX_WAKE_PRIVATE, 1);
+}
+
+bool PrintUtils::recordsPending() const
+{
+    return ring[tail % LOG_RING_SIZE].sequence.load(std::memory_order_acquire) == tail + 1;
+}
+
+// Parks the writer until a producer or shutdown bumps wakeups.
+void PrintUtils::waitForRecords()
+{
+    uint32_t seen = wakeups.load(std::memory_order_seq_cst);
+    writerSleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!recordsPending() && running.load())
+        futex(&wakeups, FUTEX_WAIT_PRIVATE, seen);
+    writerSleeping.store(0, std::memory_order_relaxed);
+}
+
+void PrintUtils::flush()
+{
+    uint64_t target = head.load(std::memory_order_acquire);
+    while (running.load())
+    {
+        // Registered before sampling drained, so a drain either finishes
+        // before the sample or sees the waiter and wakes it.
+        flushWaiters.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t seen = drained.load(std::memory_order_seq_cst);
+        if (written.load(std::memory_order_seq_cst) < target)
+            futex(&drained, FUTEX_WAIT_PRIVATE, seen);
+        flushWaiters.fetch_sub(1, std::memory_order_relaxed);
+        if (written.load(std::memory_order_acquire) >= target)
+            break;
+    }
+}
+
+// Writes up to one batch of queued messages with a single fwrite.
+int PrintUtils::drain()
+{
+    static const char *const colors[] = { "", COLOR_BGREEN, COLOR_BYELLOW, COLOR_BRED };
+    int count = 0;
+    batch.clear();
+
+    while (count < LOG_WRITE_BATCH)
+    {
+        Record &record = ring[tail % LOG_RING_SIZE];
+        if (record.sequence.load(std::memory_order_acquire) != tail + 1)
+            break;
+
+        time_t seconds = time_t(record.stampNs / 1000000000);
+        struct tm local;
+        localtime_r(&seconds, &local);
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%03d] ", local.tm_hour, local.tm_min,
+                 local.tm_sec, int(record.stampNs / 1000000 % 1000));
+
+        int level = record.level < LOG_LEVEL_DEBUG || record.level > LOG_LEVEL_ERROR
+                ? LOG_LEVEL_ERROR : record.level;
+        batch += prefix;
+        batch += colors[level];
+        batch += record.text;
+        if (*colors[level])
+            batch += COLOR_RESET;
+        batch += '\n';
+
+        record.sequence.store(tail + LOG_RING_SIZE, std::memory_order_release);
+        tail++;
+        count++;
+    }
+
+    if (count)
+    {
+        fwrite(batch.data(), 1, batch.size(), stderr);
+        fflush(stderr);
+        written.store(tail, std::memory_order_seq_cst);
+        drained.fetch_add(1, std::memory_order_seq_cst);
+        if (flushWaiters.load(std::memory_order_seq_cst))
+            futex(&drained, FUTEX_WAKE_PRIVATE, INT_MAX);
+    }
+    return count;
+}
+
+void PrintUtils::writeLoop()
+{
+    uint64_t reportedDrops = 0;
+
+    for (;;)
+    {
+        bool stopping = !running.load();
+        int count = drain();
+
+        uint64_t drops = droppedCount();
+        if (drops != reportedDrops)
+        {
+            fprintf(stderr, COLOR_BYELLOW "%llu log messages dropped" COLOR_RESET "\n",
+                    (unsigned long long)(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+
+        if (stopping && !count)
+            break;
+        if (!count)
+            waitForRecords();
+    }
+}
+
+// Registered with atexit() so queued messages reach the terminal when the
+// application returns from main(). The instance itself stays alive for
+// anything still logging from static destructors.
+void PrintUtils::shutdown()
+{
+    instance->running = false;
+    instance->wakeWriter();
+    if (instance->writer.joinable())
+        instance->writer.join();
+}
+
+PrintUtils *PrintUtils::getInstance()
+{
+    static std::once_flag created;
+    std::call_once(created, []() {
+        instance = new PrintUtils();
+        atexit(&PrintUtils::shutdown);
+    });
+    return instance;
+}
@@ -0,0 +1,109 @@
+#ifndef PRINTUTILS_H
+#define PRINTUTILS_H
+
+# define COLOR_RED		"\x1b[31m"
+# define COLOR_GREEN	"\x1b[32m"
+# define COLOR_YELLOW	"\x1b[33m"
+# define COLOR_BLUE		"\x1b[34m"
+# define COLOR_MAGENTA	"\x1b[35m"
+# define COLOR_CYAN		"\x1b[36m"
+# define COLOR_WHITE	"\x1b[37m"
+# define COLOR_BRED		"\x1b[91m"
+# define COLOR_BGREEN	"\x1b[92m"
+# define COLOR_BYELLOW	"\x1b[93m"
+# define COLOR_BBLUE	"\x1b[94m"
+# define COLOR_BMAGENTA	"\x1b[95m"
+# define COLOR_BCYAN	"\x1b[96m"
+# define COLOR_RESET	"\x1b[0m"
+
+# define LOG_LEVEL_DEBUG 0
+# define LOG_LEVEL_INFO 1
+# define LOG_LEVEL_WARN 2
+# define LOG_LEVEL_ERROR 3
+# define LOG_LEVEL_OFF 4
+
+// Messages below LOG_LEVEL are compiled out, arguments included. Per-frame
+// traces use LOG_DEBUG; build with DEFINES += LOG_LEVEL=0 to see them.
+#ifndef LOG_LEVEL
+# define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+# define LOG_RING_SIZE 1024
+# define LOG_TEXT_MAX 192
+
+#define PRINT_LOG(level, ...) \
+    do { \
+        if ((level) >= LOG_LEVEL) \
+            PrintUtils::getInstance()->log((level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(...) PRINT_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) PRINT_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) PRINT_LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) PRINT_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#include <QString>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+// Process-wide logger. log() formats into a slot of a bounded lock-free
+// ring and returns; a background thread writes the ring to stderr, so no
+// caller ever waits on the terminal. When the ring is full the message is
+// dropped and counted rather than blocking the caller. The writer sleeps
+// on a futex while the ring is empty and is woken by the first new record.
+class PrintUtils
+{
+public:
+    PrintUtils();
+    ~PrintUtils();
+
+    int PrintErrorText(const QString &errorText, int errorNo);
+    int PrintErrorText(const QString &errorText, int errorNo, int value);
+    void PrintSuccessText(const QString &Text);
+
+    void log(int level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+    // Blocks until every message queued so far has been written.
+    void flush();
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    static PrintUtils* getInstance();
+
+private:
+static PrintUtils* instance;
+
+    // Bounded MPSC queue: a slot is free for the producer whose ticket
+    // equals its sequence, and readable once the sequence is ticket + 1.
+    struct Record {
+        std::atomic<uint64_t> sequence;
+        int64_t stampNs;
+        int level;
+        char text[LOG_TEXT_MAX];
+    };
+
+    Record ring[LOG_RING_SIZE];
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) uint64_t tail;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> running;
+    // Futex words: the writer parks on wakeups, flush() on drained.
+    alignas(64) std::atomic<uint32_t> writerSleeping;
+    std::atomic<uint32_t> wakeups;
+    std::atomic<uint32_t> drained;
+    std::atomic<uint32_t> flushWaiters;
+    // Writer thread only; reserved once so draining never allocates.
+    std::string batch;
+    std::thread writer;
+
+    void writeLoop();
+    int drain();
+    bool recordsPending() const;
+    void waitForRecords();
+    void wakeWriter();
+    static void shutdown();
+};
+
+#endif // PRINTUTILS_H
@@ -0,0 +1,55 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Single-writer sequence lock. The writer never waits; a reader copies the
+// value and retries only if a store overlapped the copy. The layout is
+// address-free, so an instance can live in memory shared between processes.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock values are copied with memcpy");
+
+public:
+    SeqLock() : sequence(0) { memset(&value, 0, sizeof(value)); }
+
+    void store(const T &newValue)
+    {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&value, &newValue, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // One attempt; false if the writer was active during the copy.
+    bool tryLoad(T &out) const
+    {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        memcpy(&out, &value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    void load(T &out) const
+    {
+        while (!tryLoad(out))
+            ;
+    }
+
+    // Even values are stable versions; changes on every store.
+    uint32_t version() const { return sequence.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,114 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <new>
+#include "telemetryshm.h"
+
+static long futex(std::atomic<uint32_t> *word, int op, uint32_t value,
+                  const struct timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, NULL, 0);
+}
+
+TelemetryShm::TelemetryShm()
+    : segment(nullptr)
+{
+}
+
+TelemetryShm::~TelemetryShm()
+{
+    close();
+}
+
+// The writer creates the segment if needed and never unlinks it, so readers
+// that mapped it keep working across server restarts.
+bool TelemetryShm::open(Mode mode, const char *name)
+{
+    close();
+
+    int fd = shm_open(name, mode == Writer ? O_RDWR | O_CREAT : O_RDWR, 0660);
+    if (fd < 0)
+        return false;
+
+    if (mode == Writer && ftruncate(fd, sizeof(TelemetrySegment)) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // A segment left by an older build may be shorter than this layout;
+    // touching past its end would fault.
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < off_t(sizeof(TelemetrySegment)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    segment = static_cast<TelemetrySegment *>(addr);
+    if (mode == Writer)
+    {
+        if (!compatible())
+        {
+            new (segment) TelemetrySegment();
+            segment->magic = TELEMETRY_SHM_MAGIC;
+            segment->version = TELEMETRY_SHM_VERSION;
+            segment->size = sizeof(TelemetrySegment);
+        }
+    }
+    else if (!compatible())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Magic, version and size together: a layout change that forgot to bump
+// the version still changes the size in most cases.
+bool TelemetryShm::compatible() const
+{
+    return segment->magic == TELEMETRY_SHM_MAGIC && segment->version == TELEMETRY_SHM_VERSION &&
+            segment->size == sizeof(TelemetrySegment);
+}
+
+void TelemetryShm::close()
+{
+    if (segment)
+        munmap(segment, sizeof(TelemetrySegment));
+    segment = nullptr;
+}
+
+void TelemetryShm::publish(const Snapshot &snapshot)
+{
+    segment->latest.store(snapshot);
+    segment->notify.fetch_add(1, std::memory_order_seq_cst);
+    if (segment->waiters.load(std::memory_order_seq_cst) > 0)
+        futex(&segment->notify, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+bool TelemetryShm::wait(uint32_t seen, int timeoutMs) const
+{
+    if (notifyCount() != seen)
+        return true;
+
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    segment->waiters.fetch_add(1, std::memory_order_seq_cst);
+    futex(&segment->notify, FUTEX_WAIT, seen, &timeout);
+    segment->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    return notifyCount() != seen;
+}
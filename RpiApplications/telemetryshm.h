@@ -0,0 +1,55 @@
+#ifndef TELEMETRYSHM_H
+#define TELEMETRYSHM_H
+
+#include <atomic>
+#include "ServerConfig.h"
+#include "seqlock.h"
+
+#define TELEMETRY_SHM_NAME "/pi.chan.telemetry"
+#define TELEMETRY_SHM_MAGIC 0x50544c4d
+#define TELEMETRY_SHM_VERSION 2
+
+// Layout of the POSIX shared-memory segment. DataManager is the only
+// writer; every local consumer maps it and reads the latest Snapshot
+// without a D-Bus round trip. notify is bumped after each publish and is
+// the futex word readers sleep on. The header fields come first and never
+// move, so any build can tell whether a segment has its layout.
+struct TelemetrySegment {
+    uint32_t magic;
+    uint32_t version;
+    // sizeof(TelemetrySegment) of the build that initialised the segment.
+    uint32_t size;
+    SeqLock<Snapshot> latest;
+    alignas(64) std::atomic<uint32_t> notify;
+    std::atomic<uint32_t> waiters;
+};
+
+class TelemetryShm
+{
+public:
+    enum Mode { Writer, Reader };
+
+    TelemetryShm();
+    TelemetryShm(const TelemetryShm &) = delete;
+    TelemetryShm &operator=(const TelemetryShm &) = delete;
+    ~TelemetryShm();
+
+    bool open(Mode mode, const char *name = TELEMETRY_SHM_NAME);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+    void publish(const Snapshot &snapshot);
+
+    // Latest snapshot, never blocks on the writer.
+    void read(Snapshot &snapshot) const { segment->latest.load(snapshot); }
+    uint32_t notifyCount() const { return segment->notify.load(std::memory_order_acquire); }
+    // Sleeps until notifyCount() differs from seen or timeoutMs expires.
+    bool wait(uint32_t seen, int timeoutMs) const;
+
+private:
+    TelemetrySegment *segment;
+
+    bool compatible() const;
+};
+
+#endif // TELEMETRYSHM_H
@@ -1,33 +1,53 @@
 #include <SPI.h>
 #include <mcp_can.h>
-#include <TimerOne.h>
 
 # define pin 3
 
+// Telemetry protocol v2, frame 0x44, 8 bytes:
+//   byte 0    protocol version (2)
+//   byte 1    sequence number, +1 per frame, wraps at 256
+//   byte 2-3  speed in rpm, big-endian (same as bytes 0-1 of the old 0x43)
+//   byte 4-5  millis() when the values were sampled, low 16 bits, big-endian
+//   byte 6    temperature in deg C, SENSOR_NOT_FITTED for now
+//   byte 7    humidity in %, SENSOR_NOT_FITTED for now
+# define PROTOCOL_VERSION 2
+# define TELEMETRY_ID 0x44
+# define SEND_RATE_HZ 50
+
+// No temperature or humidity sensor is wired yet; reading the floating
+// analog pins would only send noise.
+# define SENSOR_NOT_FITTED 0
+
+// 20 slots on the encoder disc, counted on both edges.
+# define PULSES_PER_REV 40
+# define DEBOUNCE_US 700
+// Speed is the average pulse period over the newest pulses, at most
+// PULSE_WINDOW of them and none older than SPEED_WINDOW_US.
+# define PULSE_WINDOW 16
+# define SPEED_WINDOW_US 250000UL
+// Without a pulse for this long the wheel counts as stopped.
+# define STOP_TIMEOUT_US 500000UL
+
 const int spiCSPin = 10;
+const unsigned long sendPeriodUs = 1000000UL / SEND_RATE_HZ;
 
 MCP_CAN CAN(spiCSPin);
 
-int interval, wheel, counter;
-unsigned long previousMicros, usInterval, calc;
+volatile unsigned long pulseTimes[PULSE_WINDOW];
+volatile unsigned char pulseHead;
+volatile unsigned char pulseCount;
+
+unsigned long nextSendUs;
+unsigned char sequence;
+unsigned char buf[8];
 
 void setup()
 {
-  counter = 0;
-  interval = 2;
-  wheel = 20;
-
-  calc = 60 / interval;
-  usInterval = interval * 1000000;
-
-  wheel = wheel * 2;
+  pulseHead = 0;
+  pulseCount = 0;
+  sequence = 0;
 
-  Timer1.initialize(usInterval);
-  attachInterrupt(digitalPinToInterrupt(pin), count, CHANGE);
-
-  Timer1.attachInterrupt(output);
-  
-  Serial.begin(9600);
+  Serial.begin(115200);
 
   while (CAN_OK != CAN.begin(CAN_500KBPS,MCP_8MHz))
   {
@@ -36,49 +56,84 @@ void setup()
   }
   pinMode(3, INPUT);
   pinMode(2, OUTPUT);
+  attachInterrupt(digitalPinToInterrupt(pin), count, CHANGE);
   Serial.println("CAN BUS Shield Init OK!");
+
+  nextSendUs = micros();
 }
 
+// Keeps the time of every accepted edge; the speed is derived from these
+// when a frame is sent, not from a count over a fixed interval.
 void count()
 {
-  if (micros() - previousMicros >= 700)
-  {
-    counter++;
-    previousMicros = micros();
-  }
+  unsigned long now = micros();
+  unsigned char last = (pulseHead + PULSE_WINDOW - 1) % PULSE_WINDOW;
+  if (pulseCount && now - pulseTimes[last] < DEBOUNCE_US)
+    return;
+
+  pulseTimes[pulseHead] = now;
+  pulseHead = (pulseHead + 1) % PULSE_WINDOW;
+  if (pulseCount < PULSE_WINDOW)
+    pulseCount++;
 }
 
-unsigned char buf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+unsigned int readSpeed(unsigned long now)
+{
+  unsigned long times[PULSE_WINDOW];
+  unsigned char head, n;
+
+  noInterrupts();
+  head = pulseHead;
+  n = pulseCount;
+  for (unsigned char i = 0; i < n; i++)
+    times[i] = pulseTimes[(head + PULSE_WINDOW - 1 - i) % PULSE_WINDOW];
+  interrupts();
+
+  // times[0] is the newest pulse.
+  if (n < 2 || now - times[0] > STOP_TIMEOUT_US)
+    return 0;
+
+  unsigned char used = 1;
+  while (used < n && times[0] - times[used] <= SPEED_WINDOW_US)
+    used++;
+  if (used < 2)
+    used = 2;
+
+  unsigned long period = (times[0] - times[used - 1]) / (used - 1);
+  // While slowing down, the time since the last pulse bounds the period,
+  // so the speed falls smoothly instead of holding until the timeout.
+  if (now - times[0] > period)
+    period = now - times[0];
+  if (period == 0)
+    return 0;
+
+  return 60000000UL / ((unsigned long)PULSES_PER_REV * period);
+}
 
 void output()
 {
-  
-  Timer1.detachInterrupt();
-  int speed = ((counter)*calc) / wheel;
-  
-  Serial.print("Speed : ");
-  Serial.print(speed);
-  Serial.print(" | ");
-  Serial.print(speed / 256);
-  Serial.print(" | ");
-  Serial.println(speed % 256);
-  buf[0] = speed / 256;
-  buf[1] = speed % 256;
-  CAN.sendMsgBuf(0x43, 0, 8, buf);
-  counter = 0;
-  Timer1.attachInterrupt(output); 
+  unsigned long now = micros();
+  unsigned int speed = readSpeed(now);
+  unsigned int stamp = millis() & 0xffff;
+
+  buf[0] = PROTOCOL_VERSION;
+  buf[1] = sequence++;
+  buf[2] = speed / 256;
+  buf[3] = speed % 256;
+  buf[4] = stamp / 256;
+  buf[5] = stamp % 256;
+  buf[6] = SENSOR_NOT_FITTED;
+  buf[7] = SENSOR_NOT_FITTED;
+  CAN.sendMsgBuf(TELEMETRY_ID, 0, 8, buf);
 }
-    
+
+// Frames go out from the main loop on absolute deadlines: SPI transfers
+// must not run inside an interrupt, and a late frame does not shift the
+// following ones.
 void loop()
-{   
-//  Serial.println("In loop");
-//  CAN.sendMsgBuf(0x43, 0, 8, stmp);
-//
-//  double ret = analogRead(4);
-//  stmp[0] = ret;
-//
-//  Serial.print("analog input : ");
-//  Serial.println(ret);
-//
-//  delay(1000);
+{
+  if ((long)(micros() - nextSendUs) < 0)
+    return;
+  nextSendUs += sendPeriodUs;
+  output();
 }